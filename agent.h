@@ -16,10 +16,20 @@
 #include <algorithm>
 #include "board.h"
 #include "action.h"
+#include "tree.h"
+#include "playout.h"
+#include "pattern.h"
+#include "budget.h"
+#include "solver.h"
 #include <fstream>
 #include <math.h>
 #include <map>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 using hclock = std::chrono::high_resolution_clock;
 
@@ -29,19 +39,6 @@ enum PloyType
 	mctsPloy
 };
 
-struct Node
-{
-	int nb;
-	float value;
-	int nb_rave;
-	float value_rave;
-	float h;
-	std::vector<Node *> childNodes;
-	action::place selectPlace;
-};
-
-#define FLT_MIN -10000000
-
 class agent
 {
 public:
@@ -60,6 +57,8 @@ public:
 	virtual void close_episode(const std::string &flag = "") {}
 	virtual action take_action(const board &b) { return action(); }
 	virtual bool check_for_win(const board &b) { return false; }
+	virtual void start_pondering(const board &b) {} // think on the opponent's turn, until stop_pondering() is called
+	virtual void stop_pondering() {}
 
 public:
 	virtual std::string property(const std::string &key) const { return meta.at(key); }
@@ -92,6 +91,14 @@ public:
 	}
 	virtual ~random_agent() {}
 
+	// the engine is seeded again by seed=<seed>, e.g., for each game run by several threads
+	virtual void notify(const std::string &msg)
+	{
+		agent::notify(msg);
+		if (msg.substr(0, msg.find('=')) == "seed")
+			engine.seed(int(meta["seed"]));
+	}
+
 protected:
 	std::default_random_engine engine;
 };
@@ -104,8 +111,7 @@ class player : public random_agent
 {
 public:
 	player(const std::string &args = "") : random_agent("name=random role=unknown " + args),
-										   space(board::size_x * board::size_y),
-										   who(board::empty)
+										   who(board::empty), thinking(false), cores(nullptr)
 										   
 	{
 		if (name().find_first_of("[]():; ") != std::string::npos)
@@ -116,45 +122,215 @@ public:
 			who = board::white;
 		if (who == board::empty)
 			throw std::invalid_argument("invalid role: " + role());
-		initMap();
-		root = new Node{0, 0, 0, 0, 0, {}, action::place()};
+		trees.emplace_back(new search_tree);
 		board_bk = board();
+		if (meta.count("pattern") && property("pattern") != "0" && !patterns.load(property("pattern")))
+			throw std::invalid_argument("invalid pattern file: " + property("pattern"));
+		reportReuse();
 	}
-	void initMap()
-	{
-		placeMap.clear();
-		for (size_t i = 0; i < space.size(); i++)
-		{
-			space[i] = action::place(i, who);
-			placeMap.insert(std::pair<action::place,std::vector<Node *> >(action::place(i, board::black), std::vector<Node *>()));
-			placeMap.insert(std::pair<action::place,std::vector<Node *> >(action::place(i, board::white), std::vector<Node *>()));
-		}
-	}
-	// virtual void close_episode(const std::string &flag = "") {
-	// 	deleteNode(root);
-	// }
+	virtual ~player() { stop_pondering(); }
+
+	// share the cores with the other games run at once, so that the search threads= of a move are only
+	// the spare cores of the budget, which should outlive the player
+	void share_cores(core_budget *budget) { cores = budget; }
 	virtual action take_action(const board &state)
 	{
+		hclock::time_point start_time = hclock::now();
+		action move;
 		switch (ploy())
 		{
 		case PloyType::randomPloy:
-			return random_action(state);
+			move = random_action(state);
 			break;
 		case PloyType::mctsPloy:
-			return mcts_action(state);
+			if (board::count(state.legal_moves(who)) <= solveThreshold())
+				move = solve_action(state);
+			if (move.type() != action::place::type)
+				move = mcts_action(state, std::chrono::duration_cast<std::chrono::milliseconds>(hclock::now() - start_time).count());
 			break;
 		default:
 			break;
 		}
-		return action();
+		clock.spend(std::chrono::duration_cast<std::chrono::milliseconds>(hclock::now() - start_time).count());
+		return move;
+	}
+
+	virtual void open_episode(const std::string &flag = "")
+	{
+		clock.reset();
+		if (ploy() == PloyType::mctsPloy) // the other players never search
+			resetTrees();
+		reused = reuse_stats();
+		reportReuse();
+	}
+
+	// keep searching the tree after the move with ponder=1, so that the subtree of the opponent's reply is reused
+	// the pondering also stops by itself once the tree has twice its nodes at the start, or 2^pack nodes if more,
+	// so that it takes no more memory than a search of the move, or after ponder_time= milliseconds if it is set
+	virtual void start_pondering(const board &state)
+	{
+		if (ploy() != PloyType::mctsPloy || !meta.count("ponder") || property("ponder") == "0")
+			return;
+		stop_pondering();
+		board::piece_type turn = (who == board::black) ? board::white : board::black;
+		prepareWorkers(state, turn, threadCount());
+		for (auto &s : trees)
+		{
+			s->begin();
+			s->ponder_nodes = std::max(size_t(1) << packBits(), 2 * s->tree.size());
+		}
+		thinking = true;
+		int limit = ponderTime();
+		hclock::time_point start_time = hclock::now();
+		for (worker &w : workers)
+		{
+			ponderers.emplace_back([this, &w, limit, start_time]()
+			{
+				const node_arena &tree = w.search->tree;
+				for (int count = 1; thinking.load(std::memory_order_relaxed) && !proof(tree, w.search->root) && tree.size() < w.search->ponder_nodes; count++)
+				{
+					playOneSequence(w, w.search->root);
+					if (limit && count % 64 == 0 && hclock::now() - start_time >= std::chrono::milliseconds(limit))
+						break;
+				}
+			});
+		}
+	}
+	virtual void stop_pondering()
+	{
+		if (ponderers.empty())
+			return;
+		thinking = false;
+		for (std::thread &t : ponderers)
+			t.join();
+		ponderers.clear();
+		for (auto &s : trees)
+			s->end();
+	}
+
+	// the game clock is set by time_settings=<main> <byo-yomi> <stones> and time_left=<time> <stones>, in seconds as GTP
+	virtual void notify(const std::string &msg)
+	{
+		random_agent::notify(msg);
+		std::string key = msg.substr(0, msg.find('='));
+		std::stringstream ss(msg.substr(msg.find('=') + 1));
+		double main = 0, byo = 0;
+		int stones = 0;
+		if (key == "time_settings" && ss >> main >> byo >> stones)
+			clock.set(main * 1000, byo * 1000, stones);
+		else if (key == "time_left" && ss >> main >> stones)
+			clock.update(main * 1000, stones);
 	}
 
 private:
-	std::vector<action::place> space;
-	board board_bk;
+	board board_bk; // the position at the roots of the trees after the last move
 	board::piece_type who;
-	Node *root;
-	std::map <action::place, std::vector<Node *> > placeMap; 
+
+	// the moves whose tree is reused from the last move, and the visits reused, reported as reuse=<hits>/<moves> <visits>
+	struct reuse_stats
+	{
+		int moves, hits;
+		int64_t visits;
+
+		reuse_stats() : moves(0), hits(0), visits(0) {}
+	} reused;
+
+	// a search tree, which is shared by all the workers, or owned by one with parallel=root
+	struct search_tree
+	{
+		node_arena tree;
+		node_arena::index root;
+		transposition_table table;
+		int frame; // the symmetry that moves the points of the root to the real board
+		int64_t simulations; // the simulations stored in the arena since it was reset or packed, dead subtrees included
+		int base; // the visits of the root when the current search started
+		size_t ponder_nodes; // the size of the arena to stop pondering at
+
+		search_tree() : root(tree.allocate(1)), frame(0), simulations(0), base(0), ponder_nodes(0) { tree.create(root, action::place()); }
+		void begin() { base = tree.nb(root); }
+		void end() { simulations += tree.nb(root) - base; }
+	};
+	std::vector<std::unique_ptr<search_tree> > trees;
+
+	// the state of a search thread
+	struct worker
+	{
+		search_tree *search; // the tree this worker grows
+		board after; // the search board, moves are played and taken back in place
+		playout rollout; // the light board for playouts, set up with the leaf
+		playout game; // a copy of the leaf for a batch of playouts
+		std::vector<node_arena::index> path; // the selected nodes of the current simulation
+		std::vector<action::place> moves; // the moves of the selected nodes on the real board
+		std::vector<int> frames; // the symmetry that moves the points of each selected node to the real board
+		std::default_random_engine engine;
+		xorshift random; // for playouts
+		board::piece_type turn; // the side to move at the root
+		unsigned decided; // the winner of the leaf by playout::decided(), or board::empty
+
+		// the moves of a playout on the real board, with its value
+		struct sample
+		{
+			board::bitboard moves[3]; // indexed by piece_type
+			float value;
+		};
+		std::vector<sample> samples; // of the batch of playouts
+	};
+	std::vector<worker> workers;
+	pattern_table patterns; // the built-in table, or loaded by pattern=<file>
+	std::atomic<bool> thinking; // the workers are pondering
+	std::vector<std::thread> ponderers;
+	core_budget *cores; // the cores shared with the other games, or null for threads= on every move
+	solver endgame;
+
+	// the game clock of the player in milliseconds, which is set by GTP time_settings and time_left,
+	// and is also counted down by the time of each move in case time_left is not given
+	struct game_clock
+	{
+		int main, byo, stones; // the settings, main < 0 for no clock
+		int left, period; // the time left, and the stones left in the byo-yomi period, 0 in the main time
+
+		game_clock() : main(-1), byo(0), stones(0), left(0), period(0) {}
+		bool limited() const { return main >= 0 && !(byo > 0 && stones == 0); } // byo-yomi without stones is no limit as GTP
+		void set(int m, int b, int s)
+		{
+			main = m;
+			byo = b;
+			stones = s;
+			reset();
+		}
+		void reset()
+		{
+			left = main;
+			period = 0;
+			if (left <= 0 && stones)
+				left = byo, period = stones;
+		}
+		void update(int l, int s)
+		{
+			left = l;
+			period = s;
+		}
+		void spend(int elapsed)
+		{
+			if (main < 0)
+				return;
+			left -= elapsed;
+			if (period == 0 && left <= 0 && stones) // into byo-yomi
+				left += byo, period = stones;
+			else if (period && --period == 0) // a new byo-yomi period
+				left = byo, period = stones;
+		}
+	} clock;
+
+	// the limits of the search of a move, where the times are in milliseconds and 0 for no limit
+	struct search_plan
+	{
+		int simulations;
+		int planned; // the time to stop at when the best move is stable
+		int maximum; // the time to stop at anyway
+		size_t trees;
+	};
+
 	// std::map <std::string, uint> allTime;
 	PloyType ploy() const
 	{
@@ -164,66 +340,175 @@ private:
 			return PloyType::randomPloy;
 	}
 
-	int timeLimit() const { return std::stoi(property("T")); }
+	int timeLimit() const { return meta.count("T") ? std::stoi(property("T")) : 0; } // 0 for no limit
+	int simulationLimit() const { return meta.count("simulation") ? std::stoi(property("simulation")) : 900000; }
+	int batchSize() const { return meta.count("batch") ? std::max(std::stoi(property("batch")), 1) : 1; } // playouts per simulation
+	int threadCount() const { return meta.count("threads") ? std::max(std::stoi(property("threads")), 1) : 1; }
+	int tableBits() const { return meta.count("tt") ? std::min(std::max(std::stoi(property("tt")), 0), 30) : 18; } // log2 of the transposition table size, 0 to disable
+	bool symmetric() const { return meta.count("symmetry") && property("symmetry") != "0"; } // share the children of symmetric positions
+	bool rootParallel() const { return meta.count("parallel") && property("parallel") == "root"; } // one tree per thread instead of a shared one
+	int packBits() const { return meta.count("pack") ? std::min(std::max(std::stoi(property("pack")), 0), 28) : 20; } // log2 of the arena size to pack the reused tree at
+	bool usePatterns() const { return !meta.count("pattern") || property("pattern") != "0"; } // the playout policy and the priors, pattern=0 for uniform playouts
+	float priorScale() const { return meta.count("prior") ? std::stof(property("prior")) : 0.05f; } // the prior of a child is the scale times the log of its pattern weight
+	int ponderTime() const { return meta.count("ponder_time") ? std::max(std::stoi(property("ponder_time")), 0) : 0; } // in milliseconds, 0 for no limit
+	int lag() const { return meta.count("lag") ? std::stoi(property("lag")) : 50; } // the time kept for the communication of each move with a game clock
+	float stopShare() const { return meta.count("share") ? std::stof(property("share")) : 0.9f; } // the visit share of the best move to stop at, 1 to disable
+	int solveThreshold() const { return meta.count("solve") ? std::stoi(property("solve")) : 16; } // the legal points to switch to the exact solver, 0 to disable
+	int solveTime() const { return meta.count("solve_time") ? std::stoi(property("solve_time")) : (timeLimit() ? timeLimit() / 4 : 100); } // in milliseconds
 	int testId() const { return std::stoi(property("testId")); }
 
 	action random_action(const board &state)
 	{
-		std::shuffle(space.begin(), space.end(), engine);
-		for (const action::place &move : space)
+		if (state.info().who_take_turns != who)
+			return action();
+		board::bitboard moves = state.legal_moves(who);
+		if (moves == 0)
+			return action();
+		return action::place(random_point(moves, engine), who);
+	}
+
+	// pick a point uniformly from the mask, which should not be empty
+	int random_point(board::bitboard moves, std::default_random_engine &engine)
+	{
+		std::uniform_int_distribution<int> pick(0, board::count(moves) - 1);
+		return board::nth(moves, pick(engine));
+	}
+
+	// the move of a node on the real board, where frame moves the points of the node to the real board
+	action::place realPlace(const Node &node, int frame) const
+	{
+		return node.move != 0xff ? action::place(board::transformed(node.move, frame), node.color) : node.selectPlace();
+	}
+
+	// the exact solver for the endgame, which gives no action unless the position is proven won in time
+	// the search trees are dropped after a solved move, since their roots no longer lead to the position
+	action solve_action(const board &state)
+	{
+		board::point best;
+		if (endgame.solve(state, who, solveTime(), best) != solver::win)
+			return action();
+		resetTrees();
+		return action::place(best, who);
+	}
+
+	// the reuse statistics of the episode as the property reuse=<hits>/<moves> <visits>, which is shown by the GTP shell
+	void reportReuse()
+	{
+		meta["reuse"] = {std::to_string(reused.hits) + "/" + std::to_string(reused.moves) + " " + std::to_string(reused.visits)};
+	}
+
+	// drop all the search trees, their roots are then the empty position
+	void resetTrees()
+	{
+		for (auto &s : trees)
 		{
-			board after = state;
-			if (move.apply(after) == board::legal)
-			{
-				return move;
-			}
+			s->tree.reset();
+			if (s->table.enabled())
+				s->table.renew();
+			s->root = s->tree.allocate(1);
+			s->tree.create(s->root, action::place());
+			s->frame = 0;
+			s->simulations = 0;
 		}
-		return action();
+		board_bk = board();
 	}
 
-	Node * checkIsExist(const board &state, Node *node)
+	// move the root of the tree to the child of the opponent's move, or start a new tree if there is no such child
+	// the child is kept in place, and the other nodes are released only when the arena is packed by keep(),
+	// which is done once the arena is larger than 2^pack nodes, or the child has less than a quarter of the simulations
+	// stored in the arena, so that the dead subtrees are dropped as soon as they are most of the arena
+	void reuseTree(search_tree &s, action::place reply)
 	{
-		for (int i = 0; i < node->childNodes.size(); i++)
+		node_arena &tree = s.tree;
+		int frame = board::composed(tree[s.root].symmetry(), s.frame);
+		for (uint32_t i = 0; reply != action() && i < tree[s.root].size; i++)
 		{
-			action::place move = node->childNodes[i]->selectPlace;
-			if (state.check_is_who(move.position().x,move.position().y) == move.color() &&
-			    state.check_is_who(node->selectPlace.position().x, node->selectPlace.position().y) == node->selectPlace.color())
+			node_arena::index child = tree[s.root].child + i;
+			if (realPlace(tree[child], frame) != reply)
+				continue;
+			s.root = child;
+			s.frame = frame;
+			if (tree.size() > (size_t(1) << packBits()) || tree.nb(child) < s.simulations / 4)
 			{
-				deleteOther(node, move);
-				return node->childNodes[i];
+				s.root = tree.keep(s.root);
+				s.table.renew(); // the children are moved
+				s.simulations = tree.nb(s.root);
 			}
+			return;
 		}
-		deleteNode(root);
-		return root;
+		tree.reset();
+		s.table.renew();
+		s.root = tree.allocate(1);
+		tree.create(s.root, action::place());
+		s.frame = 0;
+		s.simulations = 0;
 	}
 
+	// the opponent's move that leads from the position at the roots of the trees to the state,
+	// found by the new stone and checked by the hash, or no action if the state is not reached by one move
 	action::place compareBoard(const board &state)
 	{
-		return action();
+		board::piece_type opponent = (who == board::black) ? board::white : board::black;
+		board::bitboard added = state.stones(opponent) & ~board_bk.stones(opponent);
+		if (board::count(added) != 1)
+			return action();
+		action::place move(board::first(added), opponent);
+		board after = board_bk;
+		if (move.apply(after) != board::legal || after.hash() != state.hash())
+			return action();
+		return move;
 	}
 
-	action mcts_action(const board &state)
+	// the search of a move, where spent is the time already taken by the move, e.g., by the solver, which is deducted from the plan
+	action mcts_action(const board &state, int spent = 0)
 	{
-		root = checkIsExist(state, root);
-		create_node_leaf(state, who, root);
-		int times_count = 0;
-		int simulation_count = 900000;
+		size_t treeCount = rootParallel() ? threadCount() : 1;
+		while (trees.size() < treeCount)
+			trees.emplace_back(new search_tree);
+		action::place reply = compareBoard(state);
+		for (size_t t = 0; t < treeCount; t++)
+		{
+			trees[t]->table.resize(tableBits());
+			reuseTree(*trees[t], reply);
+		}
+		reused.moves++;
+		reused.hits += (reply != action()) && trees[0]->tree[trees[0]->root].size;
+		reused.visits += trees[0]->tree.nb(trees[0]->root);
+		reportReuse();
+		int spare = cores ? cores->acquire(threadCount() - 1) : threadCount() - 1; // the search threads besides this one
+		prepareWorkers(state, who, 1 + spare);
+		for (size_t t = 0; t < treeCount; t++)
+			trees[t]->begin();
+		std::atomic<int> times_count(0);
+		std::atomic<bool> stop(false);
+		search_plan plan = planSearch(state, treeCount, spent);
 		hclock::time_point start_time = hclock::now();
-		hclock::time_point end_time = start_time;
 		// std::cout << "===timeLimit===" << std::chrono::milliseconds(timeLimit()).count() << std::endl;
 		// allTime["while"] = 0;
 		// allTime["play_game_by_policy"] = 0;
 		// allTime["create_node_leaf"] = 0;
 		// allTime["updateVlaue"] = 0;
 		// allTime["updateVlaueRAVE"] = 0;
-		initMap();
-		do
-		{
-			playOneSequence(state, root);
-			times_count++;
-			end_time = hclock::now();
-			
-		} while(times_count < simulation_count && std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() < std::chrono::milliseconds(timeLimit()).count());
+		auto search = [&](worker &w)
+		{
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				playOneSequence(w, w.search->root);
+				int elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(hclock::now() - start_time).count();
+				if (searchDone(*w.search, ++times_count, elapsed, plan))
+					stop = true;
+			}
+		};
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < workers.size(); i++)
+			threads.emplace_back(search, std::ref(workers[i]));
+		search(workers[0]);
+		for (std::thread &t : threads)
+			t.join();
+		if (cores)
+			cores->release(spare);
+		for (size_t t = 0; t < treeCount; t++)
+			trees[t]->end();
 		// std::cout << "times :" << std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count()  << "count "  << times_count << std::endl;
 		// std::cout << "times while :" << allTime["while"] << std::endl;
 		// std::cout << "times play_game_by_policy" << allTime["play_game_by_policy"] << std::endl;
@@ -231,38 +516,183 @@ private:
 		// std::cout << "times updateValue :" << allTime["updateValue"] << std::endl;
 		// std::cout << "times updateVlaueRAVE :" << allTime["updateVlaueRAVE"] << std::endl;
 		// std::cout << state << std::endl;
-		int maxIndex = -1;
-		int maxnb = 0;
-		for (int i = 0; i < root->childNodes.size(); i++)
+		// the statistics of the root children are merged over the trees by move, with their proofs
+		struct choice
 		{
-			if (root->childNodes[i]->nb > maxnb)
+			int nb;
+			float value;
+			uint8_t proof;
+		};
+		std::map<action::place, choice> merged;
+		for (size_t t = 0; t < treeCount; t++)
+		{
+			const node_arena &tree = trees[t]->tree;
+			node_arena::index root = trees[t]->root;
+			int frame = board::composed(tree[root].symmetry(), trees[t]->frame);
+			for (uint32_t i = 0; i < tree[root].size; i++)
 			{
-				maxnb = root->childNodes[i]->nb;
-				maxIndex = i;
+				node_arena::index child = tree[root].child + i;
+				choice &stat = merged[realPlace(tree[child], frame)];
+				stat.nb += tree.nb(child);
+				stat.value += tree.value(child);
+				stat.proof |= proof(tree, child);
 			}
 		}
-		if (maxIndex != -1)
+		// a proven win first, then a move not proven lost, then the most visited one
+		auto better = [](const choice &a, const choice &b)
+		{
+			if ((a.proof & Node::won) != (b.proof & Node::won))
+				return (a.proof & Node::won) != 0;
+			if ((a.proof & Node::lost) != (b.proof & Node::lost))
+				return (b.proof & Node::lost) != 0;
+			return a.nb > b.nb || (a.nb == b.nb && a.value > b.value);
+		};
+		action::place best;
+		choice maxStat = {0, 0, 0};
+		for (const auto &stat : merged)
 		{
-			deleteOther(root, root->childNodes[maxIndex]->selectPlace);
-			root = root->childNodes[maxIndex];
-			return root->selectPlace;
-		}	
-		return action();
+			if (best == action::place() || better(stat.second, maxStat))
+			{
+				maxStat = stat.second;
+				best = stat.first;
+			}
+		}
+		if (maxStat.nb == 0 && maxStat.proof == 0)
+			return action();
+		for (size_t t = 0; t < treeCount; t++)
+		{
+			search_tree &s = *trees[t];
+			int frame = board::composed(s.tree[s.root].symmetry(), s.frame);
+			for (uint32_t i = 0; i < s.tree[s.root].size; i++)
+			{
+				if (realPlace(s.tree[s.tree[s.root].child + i], frame) == best)
+				{
+					s.root = s.tree[s.root].child + i; // the other subtrees are released with the next keep() or reset()
+					s.frame = frame;
+					break;
+				}
+			}
+		}
+		board_bk = state;
+		best.apply(board_bk);
+		return best;
+	}
+
+	// expand the roots of the trees and set up the workers to search from the state, where turn is the side to move
+	// with parallel=root, the trees are kept for threads= workers even if fewer are given, so that their roots stay in step
+	void prepareWorkers(const board &state, board::piece_type turn, size_t threads)
+	{
+		size_t treeCount = rootParallel() ? threadCount() : 1;
+		while (trees.size() < treeCount)
+			trees.emplace_back(new search_tree);
+		for (size_t t = 0; t < treeCount; t++)
+			create_node_leaf(*trees[t], state, turn, trees[t]->root, trees[t]->frame);
+		workers.resize(threads);
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			worker &w = workers[i];
+			w.search = trees[i % treeCount].get();
+			w.after = state;
+			w.turn = turn;
+			w.engine.seed(engine()); // the search is reproducible with seed= when threads=1
+			w.random.seed(w.engine());
+		}
 	}
 
-	// One Simulation
-	void playOneSequence(const board &state, Node *node)
+	// plan the time of the move by the game clock if it is set, or by T= otherwise
+	// the main time is split over the expected moves left, which are about 2/5 of the legal points, plus a stone of byo-yomi
+	// the time spent on the move before the search is deducted, but at least 1 millisecond is left to search
+	search_plan planSearch(const board &state, size_t treeCount, int spent = 0)
 	{
-		std::vector<Node *> nodePath;
+		search_plan plan = {simulationLimit(), timeLimit(), timeLimit(), treeCount};
+		if (!clock.limited())
+		{
+			if (plan.maximum)
+				plan.planned = plan.maximum = std::max(timeLimit() - spent, 1);
+			return plan;
+		}
+		if (clock.period)
+		{
+			plan.planned = plan.maximum = clock.left / clock.period - lag();
+		}
+		else
+		{
+			int moves = board::count(state.legal_moves(who)) * 2 / 5 + 1;
+			int stone = clock.stones ? clock.byo / clock.stones : 0;
+			plan.planned = clock.left / moves + stone - lag();
+			plan.maximum = std::min(2 * plan.planned, clock.left / 4 + stone - lag());
+		}
+		plan.planned = std::max(plan.planned, 1);
+		plan.maximum = std::max(plan.maximum, plan.planned);
+		if (timeLimit())
+		{
+			plan.planned = std::min(plan.planned, timeLimit());
+			plan.maximum = std::min(plan.maximum, timeLimit());
+		}
+		plan.planned = std::max(plan.planned - spent, 1);
+		plan.maximum = std::max(plan.maximum - spent, 1);
+		return plan;
+	}
+
+	// whether the search of the move is done, by the simulations, the proof of the root, or the time
+	// it stops early when the most visited child can not be overtaken with the simulations left, or has most of the visits,
+	// and goes over the planned time up to the maximum when the second most visited child has a better value
+	bool searchDone(const search_tree &s, int count, int elapsed, const search_plan &plan)
+	{
+		const node_arena &tree = s.tree;
+		if (count >= plan.simulations || proof(tree, s.root) || (plan.maximum && elapsed >= plan.maximum))
+			return true;
+		bool late = plan.planned && elapsed >= plan.planned;
+		if (count % 64 && !late)
+			return false;
+		int n1 = 0, n2 = 0, total = 0;
+		float v1 = 0, v2 = 0;
+		for (uint32_t i = 0; i < tree[s.root].size; i++)
+		{
+			node_arena::index child = tree[s.root].child + i;
+			int n = tree.nb(child);
+			float v = tree.value(child);
+			total += n;
+			if (n > n1)
+				n2 = n1, v2 = v1, n1 = n, v1 = v;
+			else if (n > n2)
+				n2 = n, v2 = v;
+		}
+		bool unstable = n2 && v2 / n2 > v1 / n1;
+		if (late)
+			return !unstable;
+		int64_t left = plan.simulations - count; // the simulations left for this tree
+		if (plan.planned)
+			left = std::min<int64_t>(left, int64_t(count) * (plan.planned - elapsed) / std::max(elapsed, 1));
+		left /= plan.trees;
+		return n1 - n2 > left || n1 > stopShare() * total;
+	}
+
+	// One Simulation, the search board of the worker is restored when it returns
+	// a virtual loss is added to each selected node, so that other workers tend to select other paths
+	void playOneSequence(worker &w, node_arena::index node)
+	{
+		search_tree &s = *w.search;
+		node_arena &tree = s.tree;
+		board &after = w.after;
+		std::vector<node_arena::index> &nodePath = w.path;
+		nodePath.clear();
 		nodePath.emplace_back(node);
+		w.moves.clear();
+		w.frames.assign(1, s.frame);
 		int index = 0;
-		board after = state;
-		board::piece_type currentWho = who;
+		int frame = s.frame; // the symmetry that moves the points of the current node to the real board
+		board::piece_type currentWho = w.turn;
 		// hclock::time_point start_time = hclock::now();
-		while (nodePath.back()->childNodes.size() != 0)
+		while (__atomic_load_n(&tree[nodePath.back()].size, __ATOMIC_ACQUIRE) != 0)
 		{
-			nodePath.emplace_back(descendByUCB1(after, nodePath.back()));
-			nodePath.back()->selectPlace.apply(after);
+			frame = board::composed(tree[nodePath.back()].symmetry(), frame);
+			nodePath.emplace_back(descendByUCB1(tree, after, nodePath.back()));
+			w.frames.emplace_back(frame);
+			node_arena::add(tree.nb(nodePath.back()), 1);
+			node_arena::add(tree.value(nodePath.back()), virtualLoss(tree, nodePath.back()));
+			w.moves.emplace_back(realPlace(tree[nodePath.back()], frame));
+			after.play(w.moves.back().position(), w.moves.back().color());
 			index++;
 			if (currentWho == board::black)
 				currentWho = board::white;
@@ -271,196 +701,303 @@ private:
 		}
 		// allTime["while"] += std::chrono::duration_cast<std::chrono::microseconds>(hclock::now() - start_time).count();
 		// start_time = hclock::now();
-		play_game_by_policy(after, currentWho, nodePath.back());
+		float value = play_game_by_policy(w, after, currentWho);
 		// allTime["play_game_by_policy"] += std::chrono::duration_cast<std::chrono::microseconds>(hclock::now() - start_time).count();
 		// start_time = hclock::now();
-		create_node_leaf(after, currentWho, nodePath.back());
+		create_node_leaf(s, after, currentWho, nodePath.back(), frame);
+		if (w.decided && nodePath.size() > 1) // the leaf is won by one side whatever is played
+			prove(tree, nodePath.back(), (w.decided == tree[nodePath.back()].color) ? Node::won : Node::lost);
 		// allTime["create_node_leaf"] += std::chrono::duration_cast<std::chrono::microseconds>(hclock::now() - start_time).count();
 		// start_time = hclock::now();
-		updateValue(nodePath, nodePath.back()->value);
+		updateValue(tree, nodePath, value);
 		// allTime["updateValue"] += std::chrono::duration_cast<std::chrono::microseconds>(hclock::now() - start_time).count();
 		// start_time = hclock::now();
-		updateVlaueRAVE(nodePath, nodePath.back()->value);
+		updateVlaueRAVE(tree, w);
 		// allTime["updateVlaueRAVE"] += std::chrono::duration_cast<std::chrono::microseconds>(hclock::now() - start_time).count();
 		// start_time = hclock::now();
+		while (index--)
+			after.undo();
 	}
 	// Selection
-	Node *descendByUCB1(const board &state, Node *node)
+	// the children are scored in one SIMD pass over the statistics arrays of the arena,
+	// which picks the argmax of Q_star, where the value is negated for the opponent but the exploration is not
+	node_arena::index descendByUCB1(node_arena &tree, const board &state, node_arena::index node)
 	{
-		float nb = 0;
-		for (Node *currentNode : node->childNodes)
+		node_arena::index first = tree[node].child;
+		int size = tree[node].size;
+		if (proof(tree, node) & Node::lost) // a child is a proven win, commit to it
 		{
-			nb += currentNode->nb;
+			for (int i = 0; i < size; i++)
+				if (proof(tree, first + i) & Node::won)
+					return first + i;
 		}
+		const int *nb = &tree.nb(first);
+		const float *value = &tree.value(first);
+		const int *nb_rave = &tree.nb_rave(first);
+		const float *value_rave = &tree.value_rave(first);
+		const float *h = &tree.h(first);
 
-		std::vector<float> QList = std::vector<float>(node->childNodes.size());
-		int max_index = 0;
-		float max_Q = FLT_MIN;
-		int min_index = 0;
-		float min_Q = 1000000;
-		for (int i = 0; i < node->childNodes.size(); i++)
+		int total = 0;
+		for (int i = 0; i < size; i++)
 		{
-			float Q = 0;
-			float Q_rave = 0;
-			float exploration = 0;
-			float beta = 0.5;
-			if (node->childNodes[i]->nb == 0)
+			if (nb[i] == 0)
 			{
-				return node->childNodes[i];
-			}
-			else
-			{
-				Q = ((float)node->childNodes[i]->value / (float)node->childNodes[i]->nb);
-				exploration = sqrt(2 * log(nb) / node->childNodes[i]->nb);
-			}
-			if (node->childNodes[i]->nb_rave > 0)
-			{
-				Q_rave = ((float)node->childNodes[i]->value_rave / (float)node->childNodes[i]->nb_rave);
-			}
-			float Q_star = Q * (1.0 - beta) + (Q_rave * beta) + exploration + node->childNodes[i]->h;
-			// std::cout << "Q_star = " << Q_star << ", Q = " << Q << ",(1 - beta) = " << (1 - beta) << ",Q_rave = " << Q_rave << ", (Q_rave * beta) = " << (Q_rave * beta) << ", exploration = " << exploration << std::endl;
-			if (Q_star > max_Q){
-				max_Q = Q_star;
-				max_index = i;
-			}
-			if (Q_star < min_Q){
-				min_Q = Q_star;
-				min_index = i;
+				return first + i;
 			}
+			total += nb[i];
 		}
-		if (node->childNodes[0]->selectPlace.color() == who)
+
+		const float beta = 0.5;
+		const float sign = (tree[first].color == who) ? 1 : -1; // the opponent minimizes the value
+		const float c = 2 * log((float)total);
+		int best_index = 0;
+		float best_Q = -INFINITY;
+		int i = 0;
+#if defined(__AVX__)
+		const int width = 8;
+		__m256 vbest = _mm256_set1_ps(-INFINITY), vbest_index = _mm256_setzero_ps();
+		__m256 vindex = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+		for (; i + width <= size; i += width, vindex = _mm256_add_ps(vindex, _mm256_set1_ps(width)))
+		{
+			__m256 n = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)(nb + i)));
+			__m256 n_rave = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)(nb_rave + i)));
+			__m256 Q = _mm256_div_ps(_mm256_loadu_ps(value + i), n);
+			__m256 Q_rave = _mm256_div_ps(_mm256_loadu_ps(value_rave + i), _mm256_max_ps(n_rave, _mm256_set1_ps(1)));
+			Q_rave = _mm256_and_ps(Q_rave, _mm256_cmp_ps(n_rave, _mm256_setzero_ps(), _CMP_GT_OQ));
+			__m256 exploration = _mm256_sqrt_ps(_mm256_div_ps(_mm256_set1_ps(c), n));
+			__m256 Q_star = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(Q, _mm256_set1_ps(1 - beta)), _mm256_mul_ps(Q_rave, _mm256_set1_ps(beta))),
+			                              _mm256_loadu_ps(h + i));
+			Q_star = _mm256_add_ps(_mm256_mul_ps(Q_star, _mm256_set1_ps(sign)), exploration);
+			__m256 better = _mm256_cmp_ps(Q_star, vbest, _CMP_GT_OQ);
+			vbest = _mm256_blendv_ps(vbest, Q_star, better);
+			vbest_index = _mm256_blendv_ps(vbest_index, vindex, better);
+		}
+		float lane[width], lane_index[width];
+		_mm256_storeu_ps(lane, vbest);
+		_mm256_storeu_ps(lane_index, vbest_index);
+#elif defined(__SSE2__)
+		const int width = 4;
+		__m128 vbest = _mm_set1_ps(-INFINITY), vbest_index = _mm_setzero_ps();
+		__m128 vindex = _mm_setr_ps(0, 1, 2, 3);
+		for (; i + width <= size; i += width, vindex = _mm_add_ps(vindex, _mm_set1_ps(width)))
 		{
-			return node->childNodes[max_index];	
+			__m128 n = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(nb + i)));
+			__m128 n_rave = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(nb_rave + i)));
+			__m128 Q = _mm_div_ps(_mm_loadu_ps(value + i), n);
+			__m128 Q_rave = _mm_div_ps(_mm_loadu_ps(value_rave + i), _mm_max_ps(n_rave, _mm_set1_ps(1)));
+			Q_rave = _mm_and_ps(Q_rave, _mm_cmpgt_ps(n_rave, _mm_setzero_ps()));
+			__m128 exploration = _mm_sqrt_ps(_mm_div_ps(_mm_set1_ps(c), n));
+			__m128 Q_star = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Q, _mm_set1_ps(1 - beta)), _mm_mul_ps(Q_rave, _mm_set1_ps(beta))),
+			                           _mm_loadu_ps(h + i));
+			Q_star = _mm_add_ps(_mm_mul_ps(Q_star, _mm_set1_ps(sign)), exploration);
+			__m128 better = _mm_cmpgt_ps(Q_star, vbest);
+			vbest = _mm_or_ps(_mm_and_ps(better, Q_star), _mm_andnot_ps(better, vbest));
+			vbest_index = _mm_or_ps(_mm_and_ps(better, vindex), _mm_andnot_ps(better, vbest_index));
 		}
-		else 
+		float lane[width], lane_index[width];
+		_mm_storeu_ps(lane, vbest);
+		_mm_storeu_ps(lane_index, vbest_index);
+#else
+		const int width = 0;
+		float lane[1], lane_index[1];
+#endif
+		for (int k = 0; k < width && i > 0; k++) // the first of the best among the lanes
 		{
-			return node->childNodes[min_index];
+			if (lane[k] > best_Q || (lane[k] == best_Q && lane_index[k] < best_index))
+			{
+				best_Q = lane[k];
+				best_index = lane_index[k];
+			}
 		}
-		return node->childNodes[max_index];
+		for (; i < size; i++)
+		{
+			float Q = value[i] / nb[i];
+			float Q_rave = (nb_rave[i] > 0) ? (value_rave[i] / nb_rave[i]) : 0;
+			float exploration = sqrt(c / nb[i]);
+			float Q_star = sign * (Q * (1 - beta) + Q_rave * beta + h[i]) + exploration;
+			if (Q_star > best_Q)
+			{
+				best_Q = Q_star;
+				best_index = i;
+			}
+		}
+		return first + best_index;
+	}
+
+	// the value a node is given when selected, which is a loss for the side choosing it
+	float virtualLoss(node_arena &tree, node_arena::index node)
+	{
+		return (tree[node].color == who) ? 0 : 1;
 	}
 
-	// back propagation
-	void updateValue(std::vector<Node *> nodePath, float v)
+	// back propagation, the visits below the root were already counted with the virtual losses
+	// the proofs are propagated from the leaf up, as long as the nodes are proven
+	void updateValue(node_arena &tree, const std::vector<node_arena::index> &nodePath, float v)
 	{
 		float value = v;
-		for (int i = 0; i < nodePath.size() - 1; i++)
+		node_arena::add(tree.nb(nodePath[0]), 1);
+		node_arena::add(tree.value(nodePath[0]), value);
+		for (size_t i = 1; i < nodePath.size(); i++)
 		{
-			nodePath[i]->nb += 1;
-			nodePath[i]->value += value;
+			node_arena::add(tree.value(nodePath[i]), value - virtualLoss(tree, nodePath[i]));
 			//value = -value; 
 		}
+		for (size_t i = nodePath.size(); i-- > 0 && solve(tree, nodePath[i]);)
+			;
 	}
 
-	void updateVlaueRAVE(std::vector<Node *> nodePath, float v)
+	// MCTS-Solver, whether the node is won or lost for the player of its move
+	uint8_t proof(const node_arena &tree, node_arena::index node) const
 	{
-		if (nodePath.size() < 2) return;
-		for (int i = 1; i < nodePath.size(); i++)
-		{
-			std::vector<Node *> nodes = placeMap[nodePath[i]->selectPlace];
-			for (int j = 0; j < nodes.size(); j++)
-			{
-				nodes[j]->nb_rave +=1;
-				nodes[j]->value_rave += v;
-			}
-		}
+		return __atomic_load_n(&tree[node].flag, __ATOMIC_ACQUIRE) & (Node::won | Node::lost);
 	}
 
-	//
-	void create_node_leaf(const board &state, board::piece_type whoRound, Node *node)
+	// a node is lost if a child is won, i.e., the opponent has a winning reply, or won if all the children are lost
+	// return whether the node is proven
+	bool solve(node_arena &tree, node_arena::index node)
 	{
-		if (node->childNodes.size() > 0) return;
-		std::vector<action::place> spaceRound; //(board::size_x * board::size_y);
-		create_space(state, whoRound, spaceRound);
-		for (const action::place &move : spaceRound)
+		if (proof(tree, node))
+			return true;
+		uint32_t size = __atomic_load_n(&tree[node].size, __ATOMIC_ACQUIRE);
+		if (size == 0)
+			return false;
+		node_arena::index first = tree[node].child;
+		bool all = true;
+		for (node_arena::index child = first; child < first + size; child++)
 		{
-			board after = state;
-			if (move.apply(after) == board::legal)
+			uint8_t result = proof(tree, child);
+			if (result & Node::won)
 			{
-				// float liberty = get_liberty(state, move.position().x, move.position().y);
-				// node->childNodes.emplace_back(new Node{0, 0, 0, 0, liberty / (float)8.0, {}, move});
-				// if (testId() == 1)
-				// {
-				// 	float liberty = get_liberty(state, move.position().x, move.position().y);
-				// 	node->childNodes.emplace_back(new Node{0, 0, 10, 20, ((float)4.0 - liberty) / (float)8.0, {}, move});
-				// 	placeMap[move].emplace_back(node->childNodes.back());
-				// }
-				// else
-				// {
-				// 	node->childNodes.emplace_back(new Node{0, 0, 10, 20, 0, {}, move});
-				// 	placeMap[move].emplace_back(node->childNodes.back());
-				// }
-				// float liberty = get_liberty(state, move.position().x, move.position().y);
-				// node->childNodes.emplace_back(new Node{0, 0, 10, 20, ((float)4.0 - liberty) / (float)8.0, {}, move});
-
-				node->childNodes.emplace_back(new Node{0, 0, 20, 10, 0, {}, move});
-				placeMap[move].emplace_back(node->childNodes.back());
+				prove(tree, node, Node::lost);
+				return true;
 			}
+			all &= (result & Node::lost) != 0;
 		}
+		if (all)
+			prove(tree, node, Node::won);
+		return all;
 	}
 
-	//
-	void play_game_by_policy(const board &state, board::piece_type whoFirst, Node *node)
+	// a proven loss is ruled out of the selection by its prior, unless all the children are lost
+	void prove(node_arena &tree, node_arena::index node, uint8_t result)
 	{
-		board::piece_type whoWin = play(state, whoFirst);
-		if (whoWin == who)
-			node->value = 1;
-		else
-			node->value = 0;
-		node->nb = 1;
+		if (result == Node::lost)
+		{
+			float h = (tree[node].color == who) ? -INFINITY : INFINITY; // so that the scores by sign are -INFINITY
+			__atomic_store(&tree.h(node), &h, __ATOMIC_RELAXED);
+		}
+		__atomic_fetch_or(&tree[node].flag, result, __ATOMIC_RELEASE);
 	}
 
-	board::piece_type play(const board &state, board::piece_type whoFirst)
+	// AMAF, the children of each selected node get the value of each playout where their move is played later,
+	// either in the tree or in the playout, so the cost is linear in the length of the simulation
+	// a point is played at most once in NoGo, so the moves later than a node are the stones added after it
+	void updateVlaueRAVE(node_arena &tree, const worker &w)
 	{
-		board::piece_type whoRound = whoFirst;
-		board after = state;
-		action::place move;
-
-		std::vector<action::place> spaceA, spaceB;
-		board::piece_type p1 = whoFirst;
-		board::piece_type p2 = board::black;
-		if (p1 == board::black)
+		const std::vector<node_arena::index> &nodePath = w.path;
+		for (const worker::sample &played : w.samples)
 		{
-			p2 = board::white;
-		}
-		create_space(state, p1, spaceA);
-		create_space(state, p2, spaceB);
-		do
-		{
-			while(!spaceA.empty())
+			board::bitboard later[3] = {0, played.moves[board::black], played.moves[board::white]};
+			for (size_t i = nodePath.size(); i-- > 0;)
 			{
-				action::place move = spaceA.back();
-				if (move.apply(after) == board::legal)
+				node_arena::index node = nodePath[i];
+				uint32_t size = __atomic_load_n(&tree[node].size, __ATOMIC_ACQUIRE);
+				if (size != 0)
 				{
-					spaceA.pop_back();
-					break;
+					node_arena::index first = tree[node].child;
+					int frame = board::composed(tree[node].symmetry(), w.frames[i]);
+					board::bitboard moves = later[tree[first].color];
+					for (node_arena::index child = first; child < first + size; child++)
+					{
+						int point = frame ? board::transformed(tree[child].move, frame) : tree[child].move;
+						if ((moves >> point) & 1)
+						{
+							node_arena::accumulate(tree.nb_rave(child), 1);
+							node_arena::accumulate(tree.value_rave(child), played.value);
+						}
+					}
 				}
-				spaceA.pop_back();
+				if (i != 0)
+					later[w.moves[i - 1].color()] |= board::bit(w.moves[i - 1].position().i);
 			}
-			while(!spaceB.empty())
-			{
-				action::place move = spaceB.back();
-				if (move.apply(after) == board::legal)
-				{
-					spaceB.pop_back();
-					break;
-				}
-				spaceB.pop_back();
-			}
-		} while (!spaceA.empty() && !spaceB.empty());
-		if (spaceA.empty())
-			whoRound = p2;
-		else
-			whoRound = p1;
-		return whoRound;
+		}
 	}
 
-	void create_space(const board &state, board::piece_type whoFirst, std::vector<action::place> &spaceSort)
+	//
+	// the children are only created by the worker that claims the node, and are published by setting the size
+	// a position already in the transposition table shares the children found there instead,
+	// where frame is the symmetry that moves the points of the node to the real board
+	void create_node_leaf(search_tree &s, const board &state, board::piece_type whoRound, node_arena::index node, int frame)
 	{
-		for (int x = 0; x < 81; x++)
+		node_arena &tree = s.tree;
+		uint8_t flag = __atomic_fetch_or(&tree[node].flag, Node::expanded, __ATOMIC_ACQ_REL);
+		if (flag & Node::expanded) return;
+		int canonical = 0; // the symmetry that moves the real board to the canonical frame
+		for (int k = 1; k < 8 && symmetric(); k++)
+			if (state.hash(k) < state.hash(canonical)) canonical = k;
+		transposition_table::entry found;
+		if (s.table.enabled() && s.table.find(state.hash(canonical), found))
 		{
-			spaceSort.emplace_back(action::place(x, whoFirst));
+			int symmetry = board::composed(board::composed(found.symmetry, board::inverse(canonical)), board::inverse(frame));
+			__atomic_fetch_or(&tree[node].flag, uint8_t(symmetry << Node::symmetry_shift), __ATOMIC_RELAXED);
+			tree[node].child = found.child;
+			__atomic_store_n(&tree[node].size, found.size, __ATOMIC_RELEASE);
+			return;
 		}
-		std::shuffle(spaceSort.begin(), spaceSort.end(), engine);
+		board::bitboard moves = state.legal_moves(whoRound);
+		node_arena::index first = tree.allocate(board::count(moves));
+		if (first == node_arena::none) return; // the arena is full
+		node_arena::index child = first;
+		bool prior = usePatterns() && priorScale() != 0;
+		float sign = (whoRound == who) ? priorScale() : -priorScale(); // the priors are added to the value of who
+		for (; moves; moves &= moves - 1, child++)
+		{
+			// the children are kept in the frame of the node
+			int point = board::first(moves);
+			float h = prior ? sign * std::log(std::max(patterns.weight(whoRound, state.pattern(point)), 1e-3f)) : 0;
+			tree.create(child, action::place(board::transformed(point, board::inverse(frame)), whoRound), 20, 10, h);
+		}
+		tree[node].child = first;
+		__atomic_store_n(&tree[node].size, uint8_t(child - first), __ATOMIC_RELEASE);
+		if (child == first) // no legal move, the player of the move into the node wins
+			prove(tree, node, Node::won);
+		if (s.table.enabled() && child != first)
+			s.table.store(state.hash(canonical), {first, uint8_t(child - first), uint8_t(board::composed(frame, canonical))});
+	}
+
+	// the fraction of the batch of playouts from the leaf won by who
+	// a leaf already decided by the eyes is not played out, and its exact value is returned instead
+	float play_game_by_policy(worker &w, const board &state, board::piece_type whoFirst)
+	{
+		int batch = batchSize(), wins = 0;
+		w.rollout.reset(state); // the leaf is set up once for the whole batch
+		w.samples.clear();
+		w.decided = w.rollout.decided();
+		if (w.decided)
+			return (w.decided == who) ? 1 : 0;
+		for (int k = 0; k < batch; k++)
+		{
+			board::piece_type whoWin = play(w, state, whoFirst, k + 1 < batch);
+			if (whoWin == who)
+				wins++;
+		}
+		return float(wins) / batch;
+	}
+
+	// random playout on the light board, the side without any legal move loses
+	// a copy of the leaf is played if it is kept for more playouts, which is cheaper than setting it up again
+	// the moves of the playout are kept in the samples of the worker for AMAF
+	board::piece_type play(worker &w, const board &state, board::piece_type whoFirst, bool keep)
+	{
+		playout &game = keep ? (w.game = w.rollout) : w.rollout;
+		board::piece_type whoWin = board::piece_type(usePatterns() ? game.run(whoFirst, w.random, patterns) : game.run(whoFirst, w.random));
+		worker::sample played;
+		played.moves[board::empty] = 0;
+		played.moves[board::black] = game.stones(board::black) & ~state.stones(board::black);
+		played.moves[board::white] = game.stones(board::white) & ~state.stones(board::white);
+		played.value = (whoWin == who) ? 1 : 0;
+		w.samples.push_back(played);
+		return whoWin;
 	}
 
 	int get_liberty(const board &state, int x, int y)
@@ -477,43 +1014,4 @@ private:
 			liberty++;
 		return liberty;
 	}
-
-	// void deleteTree()
-	// {
-	// 	std::map <action::place, std::vector<Node *> >::iterator iter;
-	// 	for(auto &iter: placeMap)
-	// 	{
-	// 		for (auto &node: iter.second)
-	// 		{
-	// 			delete node;	
-	// 		}
-	// 	} 
-	// 	placeMap.clear();
-	// }
-
-	void deleteNode(Node *node){
-		if(node != nullptr){
-			for(size_t i = 0; i < node->childNodes.size(); i++){
-				deleteNode(node->childNodes[i]);
-			}
-			if(node->childNodes.size() == 0) return;
-			for (auto p : node->childNodes)
-			{
-				delete p;
-			} 
-			node->childNodes.clear();
-		}
-	}
-
-	void deleteOther(Node *node, action::place selectPlace)
-	{
-		if(node != nullptr){
-			for(size_t i = 0; i < node->childNodes.size(); i++){
-				if (node->childNodes[i]->selectPlace != selectPlace)
-				{
-					deleteNode(node->childNodes[i]);
-				}
-			}
-		}
-	}
 };
\ No newline at end of file
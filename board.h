@@ -9,12 +9,16 @@
 
 #pragma once
 #include <array>
+#include <vector>
 #include <list>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
 #include <utility>
 #include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
 
 /**
  * definition for the 9x9 board
@@ -54,9 +58,18 @@ public:
 	};
 	typedef int reward;
 
+	/**
+	 * the position is stored as one 128-bit mask per piece type (empty, black, white, hollow),
+	 * where the bit (i) is the 1-d array style index of the point, i.e., bit (x * size_y + y)
+	 */
+	typedef unsigned __int128 bitboard;
+
 public:
-	board() : stone(initial()), attr({piece_type::black}) {}
-	board(const grid& b, const data& d) : stone(b), attr(d) {}
+	board() : stone(initial_stone()), attr({piece_type::black}), key(), head(), next(), length(), libs(), code(scheme().border) {}
+	board(const grid& b, const data& d) : stone(), attr(d), key(), head(), next(), length(), libs(), code() {
+		for (int i = 0; i < size_x * size_y; i++) set(i, b[i / size_y][i % size_y]);
+		rebuild();
+	}
 	board(const board& b) = default;
 	board& operator =(const board& b) = default;
 
@@ -76,17 +89,86 @@ public:
 		}
 	};
 
-	operator grid&() { return stone; }
-	operator const grid&() const { return stone; }
-	column& operator [](unsigned x) { return stone[x]; }
-	const column& operator [](unsigned x) const { return stone[x]; }
-	cell& operator ()(unsigned i) { point p(i); return stone[p.x][p.y]; }
-	const cell& operator ()(unsigned i) const { point p(i); return stone[p.x][p.y]; }
-	cell& operator ()(const std::string& move) { point p(move); return stone[p.x][p.y]; }
-	const cell& operator ()(const std::string& move) const { point p(move); return stone[p.x][p.y]; }
+	/**
+	 * writable reference to a cell, for keeping the [x][y] and (i) accessors on top of the masks
+	 */
+	class cell_ref {
+	public:
+		cell_ref(board& b, int i) : b(b), i(i) {}
+		operator cell() const { return b.get(i); }
+		cell_ref& operator =(cell v) { b.set(i, v); b.rebuild(); return *this; }
+		cell_ref& operator =(const cell_ref& r) { return operator =(cell(r)); }
+	private:
+		board& b;
+		int i;
+	};
+	class column_ref {
+	public:
+		column_ref(board& b, unsigned x) : b(b), x(x) {}
+		cell_ref operator [](unsigned y) const { return cell_ref(b, x * size_y + y); }
+		operator column() const { return const_cast<const board&>(b)[x]; }
+	private:
+		board& b;
+		unsigned x;
+	};
+
+	operator grid() const {
+		grid g;
+		for (int i = 0; i < size_x * size_y; i++) g[i / size_y][i % size_y] = get(i);
+		return g;
+	}
+	column_ref operator [](unsigned x) { return column_ref(*this, x); }
+	column operator [](unsigned x) const {
+		column c;
+		for (int y = 0; y < size_y; y++) c[y] = get(x * size_y + y);
+		return c;
+	}
+	cell_ref operator ()(unsigned i) { return cell_ref(*this, i); }
+	cell operator ()(unsigned i) const { return get(i); }
+	cell_ref operator ()(const std::string& move) { return cell_ref(*this, point(move).i); }
+	cell operator ()(const std::string& move) const { return get(point(move).i); }
 
 	data info() const { return attr; }
-	data info(data dat) { data old = attr; attr = dat; return old; }
+	data info(data dat) { data old = attr; turn(dat); return old; }
+
+	/**
+	 * the Zobrist hash of the position, including the side to move
+	 * hash(s) is the hash of the position transformed by symmetry s, i.e.,
+	 * rotate(s % 4) then reflect_horizontal() if s >= 4, so that hash(0) is the hash of this position
+	 */
+	uint64_t hash(int s = 0) const { return key[s]; }
+
+	/**
+	 * the point that (i) is moved to by symmetry s, as in hash(s)
+	 */
+	static int transformed(int i, int s) { return scheme().symmetry[s][i]; }
+	/**
+	 * the symmetry of applying a and then b, and the symmetry that undoes a
+	 */
+	static int composed(int a, int b) { return scheme().compose[a][b]; }
+	static int inverse(int a) { return scheme().inverse[a]; }
+
+	/**
+	 * the mask of all points of the given piece type
+	 */
+	bitboard stones(unsigned who) const { return stone[who & 0b11]; }
+
+	/**
+	 * the liberties of the block of the stone at (i), which should be black or white
+	 */
+	bitboard liberties(int i) const { return libs[head[i]]; }
+
+	/**
+	 * the 3x3 pattern code of the point (i), where the bits (2d, 2d + 1) are the piece_type of the neighbor in direction d,
+	 * and the points out of the board are also hollow
+	 * the directions (dx, dy) are (-1, -1), (-1, 0), (-1, 1), (0, -1), (0, 1), (1, -1), (1, 0), (1, 1), so the opposite of d is 7 - d
+	 */
+	unsigned pattern(int i) const { return code[i]; }
+
+	/**
+	 * the neighbor of (i) in direction d as in pattern(), or size_x * size_y if it is out of the board or hollow
+	 */
+	static int around(int i, int d) { return scheme().around[i][d]; }
 
 public:
 	bool operator ==(const board& b) const { return stone == b.stone; }
@@ -116,88 +198,115 @@ public:
 		if (who == -1u) who = attr.who_take_turns;
 		if (who != attr.who_take_turns) return nogo_move_result::illegal_turn;
 		if (x == -1 && y == -1) return nogo_move_result::illegal_pass;
-		point p_min(0, 0), p_max(size_x - 1, size_y - 1);
-		if (x < p_min.x || x > p_max.x || y < p_min.y || y > p_max.y) return nogo_move_result::illegal_out_of_range;
-		if (board::initial()[x][y] == piece_type::hollow)             return nogo_move_result::illegal_out_of_range;
-		board test = *this;
-		if (test[x][y] != piece_type::empty) return nogo_move_result::illegal_not_empty;
-		test[x][y] = who; // try put a piece first
-		if (test.check_liberty(x, y, who) == 0) return nogo_move_result::illegal_suicide;
+		if (x < 0 || x >= size_x || y < 0 || y >= size_y) return nogo_move_result::illegal_out_of_range;
+		int i = point(x, y).i;
+		bitboard p = bit(i);
+		if (p & scheme().hollow) return nogo_move_result::illegal_out_of_range;
+		if (!(p & stone[empty])) return nogo_move_result::illegal_not_empty;
 		unsigned opp = 3u - who;
-		if (x > p_min.x && test.check_liberty(x - 1, y, opp) == 0) return nogo_move_result::illegal_take;
-		if (x < p_max.x && test.check_liberty(x + 1, y, opp) == 0) return nogo_move_result::illegal_take;
-		if (y > p_min.y && test.check_liberty(x, y - 1, opp) == 0) return nogo_move_result::illegal_take;
-		if (y < p_max.y && test.check_liberty(x, y + 1, opp) == 0) return nogo_move_result::illegal_take;
-		stone[x][y] = who; // is legal move!
-		attr.who_take_turns = static_cast<piece_type>(opp);
+		bitboard near = adjacent(p);
+		bool alive = near & stone[empty]; // the stone keeps a liberty of its own, or joins a block with another liberty
+		for (bitboard own = near & stone[who]; own && !alive; own &= own - 1)
+			alive = libs[head[first(own)]] & ~p;
+		if (!alive) return nogo_move_result::illegal_suicide;
+		for (bitboard take = near & stone[opp]; take; take &= take - 1)
+			if (libs[head[first(take)]] == p) return nogo_move_result::illegal_take;
+		put(i, who); // is legal move!
+		turn({static_cast<piece_type>(opp)});
 		return nogo_move_result::legal;
 	}
 	reward place(const point& p, unsigned who = piece_type::unknown) {
 		return place(p.x, p.y, who);
 	}
 
-	int check_is_who(int x, int y) const {
-		grid test = stone;
-		return test[x][y];
+	/**
+	 * play a move in place, same as place() except that a legal move is recorded so that undo() can take it back
+	 */
+	reward play(const point& p, unsigned who = piece_type::unknown) {
+		data before = attr;
+		reward result = place(p, who);
+		if (result == nogo_move_result::legal) history.push_back({uint8_t(p.i), before});
+		return result;
 	}
 
 	/**
-	 * calculate the liberty of the block of piece at [x][y]
-	 * return >= 0 if [x][y] is placed by who; otherwise return -1
+	 * take back the last move made by play()
+	 * return false if there is no such move
 	 */
-	int check_liberty(int x, int y, unsigned who) const {
-		grid test = stone;
-		if (test[x][y] != who) return -1;
-
-		int liberty = 0;
-		std::list<point> check;
-		for (check.emplace_back(x, y); check.size(); check.pop_front()) {
-			int x = check.front().x, y = check.front().y;
-			test[x][y] = piece_type::unknown; // prevent recalculate
-
-			point p_min(0, 0), p_max(size_x - 1, size_y - 1);
+	bool undo() {
+		if (history.empty()) return false;
+		change last = history.back();
+		history.pop_back();
+		bitboard p = bit(last.i);
+		unsigned who = get(last.i);
+		stone[who] &= ~p;
+		stone[empty] |= p;
+		for (int s = 0; s < 8; s++) key[s] ^= zobrist().code[s][who][last.i];
+		for (int d = 0; d < 8; d++) code[scheme().around[last.i][d]] -= who << (2 * (7 - d));
+		bitboard near = adjacent(p);
+		for (bitboard opp = near & stone[3u - who]; opp; opp &= opp - 1)
+			libs[head[first(opp)]] |= p;
+		for (bitboard own = near & stone[who]; own; ) { // split the joined block back into its parts
+			bitboard block = flood(lowest(own), stone[who]);
+			label(block);
+			own &= ~block;
+		}
+		turn(last.before);
+		return true;
+	}
 
-			cell near_l = x > p_min.x ? test[x - 1][y] : -1u; // left
-			if (near_l == piece_type::empty) liberty++;
-			else if (near_l == who) check.emplace_back(x - 1, y);
+	/**
+	 * the number of moves that can be taken back by undo()
+	 */
+	size_t depth() const { return history.size(); }
 
-			cell near_r = x < p_max.x ? test[x + 1][y] : -1u; // right
-			if (near_r == piece_type::empty) liberty++;
-			else if (near_r == who) check.emplace_back(x + 1, y);
+	/**
+	 * calculate all the legal points of who in one pass over the blocks, without trial placements
+	 * note that the side to move is not checked, i.e., place(p, who) is legal iff p is in the mask and it is who's turn
+	 */
+	bitboard legal_moves(unsigned who) const {
+		if (who != piece_type::black && who != piece_type::white) return 0;
+		bitboard safe = adjacent(stone[empty]); // a stone put next to an empty point always has a liberty
+		bitboard take = 0;
+		for (bitboard own = stone[who]; own; own &= own - 1) {
+			int k = first(own);
+			if (head[k] == k && (libs[k] & (libs[k] - 1))) safe |= libs[k]; // joining a block with two or more liberties
+		}
+		for (bitboard opp = stone[3u - who]; opp; opp &= opp - 1) {
+			int k = first(opp);
+			if (head[k] == k && !(libs[k] & (libs[k] - 1))) take |= libs[k]; // the last liberty of a block
+		}
+		return stone[empty] & safe & ~take;
+	}
 
-			cell near_d = y > p_min.y ? test[x][y - 1] : -1u; // down
-			if (near_d == piece_type::empty) liberty++;
-			else if (near_d == who) check.emplace_back(x, y - 1);
+	int check_is_who(int x, int y) const {
+		return get(point(x, y).i);
+	}
 
-			cell near_u = y < p_max.y ? test[x][y + 1] : -1u; // up
-			if (near_u == piece_type::empty) liberty++;
-			else if (near_u == who) check.emplace_back(x, y + 1);
-		}
-		return liberty;
+	/**
+	 * calculate the liberty of the block of piece at [x][y]
+	 * return >= 0 if [x][y] is placed by who; otherwise return -1
+	 */
+	int check_liberty(int x, int y, unsigned who) const {
+		int i = point(x, y).i;
+		if (get(i) != who) return -1;
+		if (who == piece_type::black || who == piece_type::white) return count(libs[head[i]]);
+		return count(adjacent(flood(bit(i), stone[who & 0b11])) & stone[empty]);
 	}
 
 	void transpose() {
-		for (int x = 0; x < size_x; x++) {
-			for (int y = x + 1; y < size_y; y++) {
-				std::swap(stone[x][y], stone[y][x]);
-			}
-		}
+		for (bitboard& b : stone) b = transposed(b);
+		rebuild();
 	}
 
 	void reflect_horizontal() {
-		for (int y = 0; y < size_y; y++) {
-			for (int x = 0; x < size_x / 2; x++) {
-				std::swap(stone[x][y], stone[size_x - 1 - x][y]);
-			}
-		}
+		for (bitboard& b : stone) b = reflected_horizontal(b);
+		rebuild();
 	}
 
 	void reflect_vertical() {
-		for (int x = 0; x < size_x; x++) {
-			for (int y = 0; y < size_y / 2; y++) {
-				std::swap(stone[x][y], stone[x][size_y - 1 - y]);
-			}
-		}
+		for (bitboard& b : stone) b = reflected_vertical(b);
+		rebuild();
 	}
 
 	/**
@@ -217,6 +326,62 @@ public:
 	void rotate_left() { transpose(); reflect_horizontal(); } // counterclockwise
 	void reverse() { reflect_horizontal(); reflect_vertical(); }
 
+public:
+	static bitboard bit(int i) { return bitboard(1) << i; }
+	static bitboard lowest(bitboard b) { return b & -b; }
+	static int first(bitboard b) { // index of the lowest bit, b should not be 0
+		uint64_t lo = uint64_t(b);
+		return lo ? __builtin_ctzll(lo) : 64 + __builtin_ctzll(uint64_t(b >> 64));
+	}
+	static int count(bitboard b) {
+		return __builtin_popcountll(uint64_t(b)) + __builtin_popcountll(uint64_t(b >> 64));
+	}
+	static int nth(bitboard b, int n) { // index of the n-th (from 0) lowest bit, b should have more than n bits
+		uint64_t v = uint64_t(b);
+		int k = __builtin_popcountll(v), base = 0;
+		if (n >= k) v = uint64_t(b >> 64), n -= k, base = 64;
+		for (; n; n--) v &= v - 1;
+		return base + __builtin_ctzll(v);
+	}
+
+	static bitboard transposed(bitboard b) {
+		bitboard t = b & scheme().diagonal[size_x - 1];
+		for (int d = 1; d < size_y; d++) { // the diagonal y - x == d moves by (size_y - 1) * d
+			t |= (b & scheme().diagonal[size_x - 1 + d]) << ((size_y - 1) * d);
+			t |= (b & scheme().diagonal[size_x - 1 - d]) >> ((size_y - 1) * d);
+		}
+		return t;
+	}
+	static bitboard reflected_horizontal(bitboard b) {
+		bitboard t = 0;
+		for (int x = 0; x < size_x; x++)
+			t |= ((b >> (x * size_y)) & scheme().column) << ((size_x - 1 - x) * size_y);
+		return t;
+	}
+	static bitboard reflected_vertical(bitboard b) {
+		bitboard t = 0;
+		for (int y = 0; y < size_y; y++)
+			t |= ((b >> y) & scheme().row[0]) << (size_y - 1 - y);
+		return t;
+	}
+
+	/**
+	 * the points next to (left, right, down, and up) any point of b
+	 */
+	static bitboard adjacent(bitboard b) {
+		const layout& s = scheme();
+		return (((b << 1) & ~s.row[0]) | ((b >> 1) & ~s.row[size_y - 1]) | (b << size_y) | (b >> size_y)) & s.range;
+	}
+
+	/**
+	 * the connected points of area that can be reached from seed
+	 */
+	static bitboard flood(bitboard seed, bitboard area) {
+		seed &= area;
+		for (bitboard grow = (seed | adjacent(seed)) & area; grow != seed; grow = (seed | adjacent(seed)) & area) seed = grow;
+		return seed;
+	}
+
 public:
 	friend std::ostream& operator <<(std::ostream& out, const board& b) {
 		std::ios ff(nullptr);
@@ -278,15 +443,216 @@ public:
 	}
 
 protected:
+	cell get(int i) const {
+		bitboard p = bit(i);
+		if (stone[black] & p) return piece_type::black;
+		if (stone[white] & p) return piece_type::white;
+		if (stone[hollow] & p) return piece_type::hollow;
+		return piece_type::empty;
+	}
+	void set(int i, cell v) {
+		bitboard p = bit(i);
+		for (bitboard& b : stone) b &= ~p;
+		stone[v <= hollow ? v : empty] |= p; // anything else is treated as empty
+	}
+
+	/**
+	 * put a stone of who at (i), which should be a legal move,
+	 * and join it with the neighboring blocks of the same color
+	 */
+	void put(int i, unsigned who) {
+		bitboard p = bit(i);
+		stone[empty] &= ~p;
+		stone[who] |= p;
+		for (int s = 0; s < 8; s++) key[s] ^= zobrist().code[s][who][i];
+		for (int d = 0; d < 8; d++) code[scheme().around[i][d]] += who << (2 * (7 - d));
+		bitboard near = adjacent(p);
+		for (bitboard opp = near & stone[3u - who]; opp; opp &= opp - 1)
+			libs[head[first(opp)]] &= ~p;
+		head[i] = next[i] = i;
+		length[i] = 1;
+		libs[i] = near & stone[empty];
+		for (bitboard own = near & stone[who] & ~p; own; own &= own - 1)
+			join(head[i], head[first(own)]);
+		libs[head[i]] &= ~p;
+	}
+
+	/**
+	 * merge two blocks given by their heads, the shorter one is relabeled
+	 */
+	void join(int a, int b) {
+		if (a == b) return;
+		if (length[a] < length[b]) std::swap(a, b);
+		int k = b;
+		do { head[k] = a; k = next[k]; } while (k != b);
+		std::swap(next[a], next[b]);
+		length[a] += length[b];
+		libs[a] |= libs[b];
+	}
+
+	/**
+	 * recalculate all the blocks and their liberties from the masks
+	 */
+	void rebuild() {
+		for (bitboard todo = stone[black] | stone[white]; todo; ) {
+			bitboard block = flood(lowest(todo), stone[get(first(todo))]);
+			label(block);
+			todo &= ~block;
+		}
+		for (int s = 0; s < 8; s++) {
+			key[s] = attr.who_take_turns == piece_type::white ? zobrist().turn : 0;
+			for (unsigned who = black; who <= white; who++)
+				for (bitboard m = stone[who]; m; m &= m - 1) key[s] ^= zobrist().code[s][who][first(m)];
+		}
+		code = scheme().border;
+		for (unsigned who = black; who <= white; who++)
+			for (bitboard m = stone[who]; m; m &= m - 1)
+				for (int d = 0; d < 8; d++) code[scheme().around[first(m)][d]] += who << (2 * (7 - d));
+	}
+
+	/**
+	 * change the game data, and the side to move in the hash
+	 */
+	void turn(const data& dat) {
+		if ((attr.who_take_turns == piece_type::white) != (dat.who_take_turns == piece_type::white))
+			for (uint64_t& k : key) k ^= zobrist().turn;
+		attr = dat;
+	}
+
+	/**
+	 * make the given stones a block, headed by its lowest point
+	 */
+	void label(bitboard block) {
+		int h = first(block), last = h;
+		length[h] = 0;
+		for (bitboard m = block; m; m &= m - 1) {
+			int k = first(m);
+			head[k] = h;
+			next[last] = k;
+			last = k;
+			length[h]++;
+		}
+		next[last] = h;
+		libs[h] = adjacent(block) & stone[empty];
+	}
+
+	/**
+	 * the constant masks for the board geometry
+	 */
+	struct layout {
+		bitboard range; // all the points of the board
+		bitboard hollow; // the hollow center
+		bitboard row[size_y]; // row[y] contains the points [0..size_x)[y]
+		bitboard column; // the points [0][0..size_y)
+		bitboard diagonal[size_x + size_y - 1]; // diagonal[size_x - 1 + d] contains the points where y - x == d
+		uint8_t symmetry[8][size_x * size_y]; // symmetry[s][i] is the point that (i) is moved to by symmetry s
+		uint8_t compose[8][8]; // compose[a][b] is the symmetry of a followed by b
+		uint8_t inverse[8];
+		uint8_t around[size_x * size_y][8]; // the neighbors of each point by direction, or the spare point out of the board
+		std::array<uint16_t, size_x * size_y + 1> border; // the pattern code of each point on the empty board
+	};
+	static const layout& scheme() { static layout masks; return masks; }
+
+	/**
+	 * the random codes for hashing, where code[s][who][i] is the code of a stone of who
+	 * at the point that (i) is moved to by symmetry s
+	 */
+	struct hashing {
+		uint64_t code[8][3][size_x * size_y];
+		uint64_t turn; // for white to move
+	};
+	static const hashing& zobrist() { static hashing codes; return codes; }
 	static const grid& initial() { static grid stone; return stone; }
+	static const std::array<bitboard, 4>& initial_stone() { static std::array<bitboard, 4> stone; return stone; }
 	static __attribute__((constructor)) void init_initial_scheme() {
 		grid& stone = const_cast<grid&>(initial());
 		point hollow((size_x - hollow_x) / 2, (size_y - hollow_y) / 2);
 		for (int x = hollow.x; x < hollow.x + hollow_x; x++)
 			for (int y = hollow.y; y < hollow.y + hollow_y; y++)
 				stone[x][y] = piece_type::hollow;
+
+		layout& masks = const_cast<layout&>(scheme());
+		for (int x = 0; x < size_x; x++) {
+			for (int y = 0; y < size_y; y++) {
+				bitboard p = bit(point(x, y).i);
+				masks.range |= p;
+				if (stone[x][y] == piece_type::hollow) masks.hollow |= p;
+				masks.row[y] |= p;
+				if (x == 0) masks.column |= p;
+				masks.diagonal[size_x - 1 + y - x] |= p;
+			}
+		}
+		const int dx[8] = { -1, -1, -1, 0, 0, 1, 1, 1 }, dy[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+		for (int x = 0; x < size_x; x++) {
+			for (int y = 0; y < size_y; y++) {
+				int i = point(x, y).i;
+				masks.border[i] = 0;
+				for (int d = 0; d < 8; d++) {
+					int u = x + dx[d], v = y + dy[d];
+					bool inside = u >= 0 && u < size_x && v >= 0 && v < size_y && stone[u][v] != piece_type::hollow;
+					masks.around[i][d] = inside ? point(u, v).i : size_x * size_y;
+					if (!inside) masks.border[i] |= piece_type::hollow << (2 * d);
+				}
+			}
+		}
+		std::array<bitboard, 4>& init = const_cast<std::array<bitboard, 4>&>(initial_stone());
+		init[piece_type::empty] = masks.range & ~masks.hollow;
+		init[piece_type::hollow] = masks.hollow;
+
+		hashing& codes = const_cast<hashing&>(zobrist());
+		std::mt19937_64 engine(0x9e3779b97f4a7c15ull); // fixed, so that hashes are the same across runs
+		uint64_t code[3][size_x * size_y] = {};
+		for (unsigned who = black; who <= white; who++)
+			for (int i = 0; i < size_x * size_y; i++) code[who][i] = engine();
+		codes.turn = engine();
+		for (int s = 0; s < 8; s++) {
+			for (int i = 0; i < size_x * size_y; i++) {
+				bitboard p = bit(i);
+				for (int r = 0; r < s % 4; r++) p = reflected_vertical(transposed(p)); // clockwise
+				if (s >= 4) p = reflected_horizontal(p);
+				masks.symmetry[s][i] = first(p);
+				for (unsigned who = black; who <= white; who++) codes.code[s][who][i] = code[who][first(p)];
+			}
+		}
+		for (int a = 0; a < 8; a++) {
+			for (int b = 0; b < 8; b++) {
+				for (int c = 0; c < 8; c++) {
+					int i = 0;
+					while (i < size_x * size_y && masks.symmetry[c][i] == masks.symmetry[b][masks.symmetry[a][i]]) i++;
+					if (i == size_x * size_y) masks.compose[a][b] = c;
+				}
+			}
+			for (int b = 0; b < 8; b++)
+				if (masks.compose[a][b] == 0) masks.inverse[a] = b;
+		}
 	}
 private:
-	grid stone;
+	std::array<bitboard, 4> stone; // indexed by piece_type
 	data attr;
+	std::array<uint64_t, 8> key; // the hash under each symmetry
+
+	/**
+	 * the blocks of connected stones, kept up to date on each placement
+	 * each block is a circular list (next) of its stones, all labeled with the same head,
+	 * where the length and the liberties (libs) of the block are stored at the head
+	 */
+	std::array<uint8_t, size_x * size_y> head;
+	std::array<uint8_t, size_x * size_y> next;
+	std::array<uint8_t, size_x * size_y> length;
+	std::array<bitboard, size_x * size_y> libs;
+
+	/**
+	 * the pattern code of each point, kept up to date on each placement,
+	 * with a spare entry for the neighbors out of the board
+	 */
+	std::array<uint16_t, size_x * size_y + 1> code;
+
+	/**
+	 * the moves made by play(), for undo()
+	 */
+	struct change {
+		uint8_t i;
+		data before;
+	};
+	std::vector<change> history;
 };
@@ -0,0 +1,41 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * budget.h: Define the budget of cores shared by the games run at once
+ *
+ * Author: Theory of Computer Games (TCG 2021)
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <atomic>
+#include <algorithm>
+
+/**
+ * the spare cores of the machine, which are shared by the games run at once and the search threads of their moves
+ * a running game holds a core of its own, and a move borrows the spare cores for more search threads,
+ * so that the threads never outnumber the cores, and the cores of the finished games go to the games still running
+ */
+class core_budget {
+public:
+	core_budget(int spare = 0) : spare(spare) {}
+
+	/**
+	 * take up to n spare cores without waiting, and return the number taken
+	 */
+	int acquire(int n) {
+		int left = spare.load(std::memory_order_relaxed), taken;
+		do {
+			taken = std::max(std::min(n, left), 0);
+		} while (taken && !spare.compare_exchange_weak(left, left - taken, std::memory_order_relaxed));
+		return taken;
+	}
+
+	/**
+	 * give back n cores, which were taken by acquire() or held by a game
+	 */
+	void release(int n) { spare.fetch_add(n, std::memory_order_relaxed); }
+
+private:
+	std::atomic<int> spare;
+};
@@ -14,7 +14,11 @@
 #include <iostream>
 #include <sstream>
 #include <chrono>
+#include <ctime>
+#include <iomanip>
 #include <numeric>
+#include <cstring>
+#include <cstdint>
 #include "board.h"
 #include "action.h"
 #include "agent.h"
@@ -33,6 +37,18 @@ public:
 	const board& state() const { return ep_state; }
 	board::reward score() const { return ep_score; }
 
+	/**
+	 * reset to a new episode, where the storage of the moves is kept
+	 */
+	void clear() {
+		ep_state = initial_state();
+		ep_score = 0;
+		ep_moves.clear();
+		ep_time = 0;
+		ep_open = {};
+		ep_close = {};
+	}
+
 	void open_episode(const std::string& tag) {
 		ep_open = { tag, millisec() };
 	}
@@ -117,7 +133,8 @@ public:
 		out << "PB[" << names.substr(0, names.find(':')) << "]";
 		out << "PW[" << names.substr(names.find(':') + 1) << "]";
 		time_t date = ep.ep_open.when / 1000;
-		out << "DT[" << std::put_time(std::localtime(&date), "%Y-%m-%d") << "]";
+		std::tm local; // localtime_r() since the records may be written by several threads at once
+		out << "DT[" << std::put_time(localtime_r(&date, &local), "%Y-%m-%d") << "]";
 		std::string winner = ep.ep_close.tag;
 		out << "RE[" << (names.find(winner) == 0 ? "B" : "W") << "+R]";
 		out << "C[TCG|" << ep.ep_open << "|" << ep.ep_close << "]";
@@ -149,6 +166,83 @@ public:
 		return in;
 	}
 
+public:
+	/**
+	 * the binary format of a record, which is much faster to write and read than the text one
+	 * a record is a fixed header of 20 bytes, which are the flags, the number of moves, the sizes of the tags,
+	 * and the times of open and close (in milliseconds, 8 bytes each in little-endian),
+	 * followed by the tags of open and close (players and winner), 1 byte per move as (i) | 0x80 for white,
+	 * and the time of each move as a varint if bit 0 of the flags is set
+	 * a file of binary records starts with binary_magic, so that it can be told from a file of text records
+	 */
+	static constexpr const char* binary_magic = "NoGoBin1";
+	static constexpr size_t binary_header = 20;
+
+	/**
+	 * append the record in the binary format to the buffer
+	 */
+	void write_binary(std::string& out) const {
+		bool timed = std::any_of(ep_moves.begin(), ep_moves.end(), [](const move& mv) { return mv.time != 0; });
+		size_t open_size = std::min<size_t>(ep_open.tag.size(), 255), close_size = std::min<size_t>(ep_close.tag.size(), 255);
+		uint8_t head[binary_header] = { uint8_t(timed), uint8_t(ep_moves.size()), uint8_t(open_size), uint8_t(close_size) };
+		for (int k = 0; k < 8; k++) {
+			head[4 + k] = uint8_t(uint64_t(ep_open.when) >> (8 * k));
+			head[12 + k] = uint8_t(uint64_t(ep_close.when) >> (8 * k));
+		}
+		out.append(reinterpret_cast<const char*>(head), binary_header);
+		out.append(ep_open.tag, 0, open_size);
+		out.append(ep_close.tag, 0, close_size);
+		for (const move& mv : ep_moves) {
+			action::place place(mv.code);
+			out.push_back(char(place.position().i | (place.color() == board::white ? 0x80 : 0)));
+		}
+		for (size_t i = 0; timed && i < ep_moves.size(); i++) {
+			for (uint64_t t = ep_moves[i].time; ; t >>= 7) {
+				out.push_back(char((t & 0x7f) | (t >= 0x80 ? 0x80 : 0)));
+				if (t < 0x80) break;
+			}
+		}
+	}
+
+	/**
+	 * read a record in the binary format from p and advance p past it, where the storage of this record is reused
+	 * return false at the end of the records or if the record is truncated
+	 */
+	bool read_binary(const char*& p, const char* end) {
+		const uint8_t* in = reinterpret_cast<const uint8_t*>(p);
+		const uint8_t* last = reinterpret_cast<const uint8_t*>(end);
+		if (last - in < ptrdiff_t(binary_header)) return false;
+		bool timed = in[0] & 1;
+		size_t moves = in[1], open_size = in[2], close_size = in[3];
+		uint64_t open_when = 0, close_when = 0;
+		for (int k = 0; k < 8; k++) {
+			open_when |= uint64_t(in[4 + k]) << (8 * k);
+			close_when |= uint64_t(in[12 + k]) << (8 * k);
+		}
+		in += binary_header;
+		if (size_t(last - in) < open_size + close_size + moves) return false;
+		clear();
+		ep_open.tag.assign(reinterpret_cast<const char*>(in), open_size);
+		ep_open.when = time_t(open_when);
+		in += open_size;
+		ep_close.tag.assign(reinterpret_cast<const char*>(in), close_size);
+		ep_close.when = time_t(close_when);
+		in += close_size;
+		for (size_t i = 0; i < moves; i++, in++)
+			ep_moves.emplace_back(action::place(*in & 0x7f, (*in & 0x80) ? board::white : board::black));
+		for (size_t i = 0; timed && i < moves; i++) {
+			uint64_t t = 0;
+			for (int shift = 0; ; shift += 7) {
+				if (in == last) return false;
+				t |= uint64_t(*in & 0x7f) << shift;
+				if (!(*in++ & 0x80)) break;
+			}
+			ep_moves[i].time = time_t(t);
+		}
+		p = reinterpret_cast<const char*>(in);
+		return true;
+	}
+
 protected:
 
 	struct move {
@@ -0,0 +1,62 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * mapping.h: Utility for reading a file through a read-only memory mapping
+ *
+ * Author: Theory of Computer Games (TCG 2021)
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * a read-only memory mapping of a whole file, so that the file is scanned in place without being copied
+ * the pages are read on demand and advised for a sequential scan
+ */
+class mapping {
+public:
+	mapping() : base(nullptr), length(0) {}
+	mapping(const mapping&) = delete;
+	mapping& operator =(const mapping&) = delete;
+	~mapping() { close(); }
+
+	/**
+	 * map the file, return false if it can not be opened or mapped, where an empty file is mapped as empty
+	 */
+	bool open(const std::string& path) {
+		close();
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		struct stat info;
+		bool ok = fstat(fd, &info) == 0;
+		length = ok ? size_t(info.st_size) : 0;
+		if (ok && length) {
+			void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+			ok = p != MAP_FAILED;
+			base = ok ? static_cast<const char*>(p) : nullptr;
+			if (ok) madvise(p, length, MADV_SEQUENTIAL);
+		}
+		::close(fd);
+		if (!ok) length = 0;
+		return ok;
+	}
+
+	void close() {
+		if (base) munmap(const_cast<char*>(base), length);
+		base = nullptr;
+		length = 0;
+	}
+
+	const char* begin() const { return base; }
+	const char* end() const { return base + length; }
+	size_t size() const { return length; }
+
+private:
+	const char* base;
+	size_t length;
+};
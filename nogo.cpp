@@ -11,11 +11,17 @@
 #include <fstream>
 #include <iterator>
 #include <string>
+#include <thread>
+#include <random>
+#include <cstring>
+#include <cstdio>
 #include "board.h"
 #include "action.h"
 #include "agent.h"
 #include "episode.h"
 #include "statistic.h"
+#include "recorder.h"
+#include "mapping.h"
 
 int main(int argc, const char *argv[])
 {
@@ -24,7 +30,7 @@ int main(int argc, const char *argv[])
 	std::cout << std::endl
 			  << std::endl;
 
-	size_t total = 1000, block = 0, limit = 0;
+	size_t total = 1000, block = 0, limit = 0, jobs = 1, sync = 0, cores = std::max(std::thread::hardware_concurrency(), 1u);
 	std::string black_args, white_args;
 	std::string load, save;
 	std::string name = "TCG-HollowNoGo-Demo", version = "2021"; // for GTP shell
@@ -44,6 +50,14 @@ int main(int argc, const char *argv[])
 		{
 			limit = std::stoull(para.substr(para.find("=") + 1));
 		}
+		else if (para.find("--jobs=") == 0)
+		{
+			jobs = std::max<size_t>(std::stoull(para.substr(para.find("=") + 1)), 1);
+		}
+		else if (para.find("--cores=") == 0)
+		{
+			cores = std::max<size_t>(std::stoull(para.substr(para.find("=") + 1)), 1);
+		}
 		else if (para.find("--black=") == 0)
 		{
 			black_args = para.substr(para.find("=") + 1);
@@ -60,6 +74,10 @@ int main(int argc, const char *argv[])
 		{
 			save = para.substr(para.find("=") + 1);
 		}
+		else if (para.find("--sync=") == 0)
+		{
+			sync = std::stoull(para.substr(para.find("=") + 1));
+		}
 		else if (para.find("--name=") == 0)
 		{
 			name = para.substr(para.find("=") + 1);
@@ -80,18 +98,110 @@ int main(int argc, const char *argv[])
 
 	statistic stat(total, block, limit);
 
+	// the records are saved as they are closed, starting with the loaded ones, in the binary format if the file is *.bin
+	// a file saved over the loaded one is written aside and renamed at the end
+	recorder rec;
+	std::string saving = (save.size() && save == load) ? save + ".part" : save;
+	bool binary = save.size() >= 4 && save.compare(save.size() - 4, 4, ".bin") == 0;
+	if (save.size() && !rec.open(saving, sync, binary))
+		std::cerr << "cannot open " << saving << std::endl;
+
 	if (load.size())
-	{
-		std::ifstream in(load, std::ios::in);
-		in >> stat;
-		in.close();
+	{ // the binary records are scanned in place, the text ones are read by lines
+		mapping log;
+		size_t magic = std::strlen(episode::binary_magic);
+		if (log.open(load) && log.size() >= magic && std::memcmp(log.begin(), episode::binary_magic, magic) == 0)
+		{
+			episode ep;
+			for (const char *p = log.begin() + magic; ep.read_binary(p, log.end());)
+			{
+				rec.record(ep);
+				stat.load_episode(ep);
+			}
+		}
+		else
+		{
+			std::ifstream in(load, std::ios::in);
+			episode ep;
+			for (std::string line; std::getline(in, line) && line.size();)
+			{
+				std::stringstream(line) >> ep;
+				rec.record(ep);
+				stat.load_episode(ep);
+			}
+		}
 		summary |= stat.is_finished();
 	}
 
 	player black("name=black ploy=random " + black_args + " role=black");
 	player white("name=white ploy=random " + white_args + " role=white");
 
-	if (!shell)
+	if (!shell && jobs > 1)
+	{ // launch local games on several threads, each with its own players
+		// the players are seeded again for each game by its number, from their seed= if it is given, or a random seed otherwise,
+		// so the threads play different games, and a run with the seeds given plays the same games whichever thread runs them
+		// each thread holds a core of the budget, and the search threads= of a move are the spare cores only,
+		// so the threads never outnumber the cores, and the threads that run out of games give their cores to the others
+		jobs = std::min(jobs, cores);
+		core_budget budget(cores - jobs);
+		std::random_device device;
+		auto seed_of = [&device](const std::string &args)
+		{
+			unsigned seed = device();
+			std::stringstream ss(args);
+			for (std::string pair; ss >> pair;)
+				if (pair.find("seed=") == 0)
+					seed = unsigned(std::stoul(pair.substr(pair.find("=") + 1)));
+			return seed;
+		};
+		unsigned black_seed = seed_of(black_args), white_seed = seed_of(white_args);
+		auto mix = [](unsigned seed, size_t n)
+		{ // the seed of a player in a game by its number, scrambled so that nearby numbers play unlike games
+			uint64_t z = (uint64_t(seed) << 32 | n) * 0x9e3779b97f4a7c15ull;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			return unsigned((z ^ (z >> 31)) & 0x7fffffff);
+		};
+		auto arena = [&]()
+		{
+			player black("name=black ploy=random " + black_args + " role=black");
+			player white("name=white ploy=random " + white_args + " role=white");
+			black.share_cores(&budget);
+			white.share_cores(&budget);
+			episode game;
+			for (size_t n; (n = stat.reserve());)
+			{
+				black.notify("seed=" + std::to_string(mix(black_seed, 2 * n)));
+				white.notify("seed=" + std::to_string(mix(white_seed, 2 * n + 1)));
+				black.open_episode("~:" + white.name());
+				white.open_episode(black.name() + ":~");
+
+				game.clear();
+				game.open_episode(black.name() + ":" + white.name());
+				while (true)
+				{
+					agent &who = game.take_turns(black, white);
+					action move = who.take_action(game.state());
+					if (game.apply_action(move) != true) break;
+					if (who.check_for_win(game.state())) break;
+				}
+				agent &win = game.last_turns(black, white);
+				game.close_episode(win.name());
+				rec.record(game);
+				stat.add_episode(game);
+
+				black.close_episode(win.name());
+				white.close_episode(win.name());
+			}
+			budget.release(1);
+		};
+		std::vector<std::thread> threads;
+		for (size_t k = 0; k < jobs; k++)
+			threads.emplace_back(arena);
+		for (std::thread &t : threads)
+			t.join();
+	}
+	else if (!shell)
 	{ // launch standard local games
 		while (!stat.is_finished())
 		{
@@ -112,6 +222,7 @@ int main(int argc, const char *argv[])
 			}
 			agent &win = game.last_turns(black, white);
 			stat.close_episode(win.name());
+			rec.record(game);
 
 			black.close_episode(win.name());
 			white.close_episode(win.name());
@@ -125,6 +236,8 @@ int main(int argc, const char *argv[])
 				command.pop_back();
 			if (command.empty())
 				continue;
+			black.stop_pondering(); // any command may change the game
+			white.stop_pondering();
 
 			std::vector<std::string> args;
 			std::istringstream iss(command);
@@ -190,6 +303,7 @@ int main(int argc, const char *argv[])
 					if (game.apply_action(move) == true)
 					{
 						reply = move.position();
+						who.start_pondering(game.state());
 					}
 					else
 					{ // I have no legal move to play
@@ -203,12 +317,28 @@ int main(int argc, const char *argv[])
 				{ // should close an opened episode
 					agent &win = stat.back().last_turns(black, white);
 					stat.close_episode(win.name());
+					rec.record(stat.back());
 					black.close_episode(win.name());
 					white.close_episode(win.name());
 				}
 				if (args[0] == "quit")
 					break; // quit GTP shell
 			}
+			else if (args[0] == "time_settings" && args.size() >= 4)
+			{ // set the game clock of both players, main time, byo-yomi time and stones
+				black.notify("time_settings=" + args[1] + " " + args[2] + " " + args[3]);
+				white.notify("time_settings=" + args[1] + " " + args[2] + " " + args[3]);
+			}
+			else if (args[0] == "time_left" && args.size() >= 4)
+			{ // update the game clock of a player, time left and stones left in byo-yomi
+				agent &who = (std::tolower(args[1][0]) == 'b') ? black : white;
+				who.notify("time_left=" + args[2] + " " + args[3]);
+			}
+			else if (args[0] == "reuse_stats" && args.size() >= 2)
+			{ // report the subtrees reused by a player in this game, as <hits>/<moves> <visits>
+				agent &who = (std::tolower(args[1][0]) == 'b') ? black : white;
+				reply = who.property("reuse");
+			}
 			else if (args[0] == "showboard")
 			{ // print the board
 				std::stringstream buf;
@@ -243,6 +373,9 @@ int main(int argc, const char *argv[])
 				reply = "play\n"
 						"genmove\n"
 						"clear_board\n"
+						"time_settings\n"
+						"time_left\n"
+						"reuse_stats\n"
 						"showboard\n"
 						"boardsize\n"
 						"name\n"
@@ -266,12 +399,13 @@ int main(int argc, const char *argv[])
 		stat.summary();
 	}
 
-	if (save.size())
-	{
-		std::ofstream out(save, std::ios::out | std::ios::trunc);
-		out << stat;
-		out.close();
+	if (stat.is_episode_ongoing())
+	{ // the shell is ended in a game
+		rec.record(stat.back());
 	}
+	rec.close();
+	if (saving != save)
+		std::rename(saving.c_str(), save.c_str());
 
 	return 0;
 }
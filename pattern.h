@@ -0,0 +1,154 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * pattern.h: Define the table of 3x3 patterns for the playout policy and the priors of the search
+ *
+ * Author: Theory of Computer Games (TCG 2021)
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <array>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include "board.h"
+
+/**
+ * the weights of the 3x3 patterns for each side, indexed by the pattern code of board::pattern()
+ * a move is better with a larger weight, and the default weight is 1
+ *
+ * the weights can be loaded from a text file, where each line is a pattern and its weight, e.g.,
+ *   ### X.X ?.? 0.1
+ * the three rows are from top to bottom around the move at the center, with '.' for empty, 'X' for the side to move,
+ * 'O' for the opponent, '#' for the edge or the hollow, and '?' for any of them
+ * a pattern also sets its symmetric ones, a later line overrides an earlier one, and a line starting with "//" is a comment
+ */
+class pattern_table {
+public:
+	enum : unsigned { codes = 1u << 16 };
+
+	/**
+	 * the default table, which only keeps the side to move from filling its own eyes,
+	 * i.e., the points whose sides are all its own stones or the edge
+	 */
+	pattern_table() {
+		for (unsigned who = board::black; who <= board::white; who++)
+			weights[who].assign(codes, 1), chances[who].assign(codes, 255);
+		const int side[4] = { 1, 4, 6, 9 }; // the characters of the sides in the file format
+		for (int sides = 0; sides < 16; sides++) { // each side is either 'X' or '#'
+			std::string eye = "?X? X.X ?X?";
+			for (int k = 0; k < 4; k++)
+				if ((sides >> k) & 1) eye[side[k]] = '#';
+			set(eye, 0.1f);
+		}
+		normalize();
+	}
+
+	/**
+	 * load the patterns from the file, return false if it can not be read or has a bad line
+	 */
+	bool load(const std::string& path) {
+		std::ifstream in(path);
+		if (!in) return false;
+		for (std::string line; std::getline(in, line); ) {
+			std::stringstream ss(line);
+			std::string rows[3];
+			float weight;
+			if (!(ss >> rows[0]) || rows[0].find("//") == 0) continue;
+			if (!(ss >> rows[1] >> rows[2] >> weight) || !set(rows[0] + " " + rows[1] + " " + rows[2], weight)) return false;
+		}
+		normalize();
+		return true;
+	}
+
+	/**
+	 * the weight of a move of who with the pattern code
+	 */
+	float weight(unsigned who, unsigned code) const { return weights[who][code]; }
+
+	/**
+	 * the chance in [0, 255] to accept a move of who with the pattern code, which is its weight relative to the largest one
+	 */
+	unsigned chance(unsigned who, unsigned code) const { return chances[who][code]; }
+
+private:
+	/**
+	 * set the weight of the pattern in the file format, return false if it is malformed
+	 */
+	bool set(const std::string& pattern, float weight) {
+		// the characters of the rows in the order of the directions of board::pattern()
+		static const int at[8] = { 8, 4, 0, 9, 1, 10, 6, 2 };
+		if (pattern.size() != 11 || pattern[3] != ' ' || pattern[7] != ' ' || weight < 0) return false;
+		std::array<int, 8> cells;
+		for (int d = 0; d < 8; d++) {
+			static const std::string types = ".XO#?";
+			size_t t = types.find(pattern[at[d]]);
+			if (t == std::string::npos) return false;
+			cells[d] = int(t);
+		}
+		for (int s = 0; s < 8; s++) {
+			std::array<int, 8> moved;
+			for (int d = 0; d < 8; d++) moved[symmetry(d, s)] = cells[d];
+			assign(moved, 0, 0, weight);
+		}
+		return true;
+	}
+
+	/**
+	 * update the chances from the weights
+	 */
+	void normalize() {
+		for (unsigned who = board::black; who <= board::white; who++) {
+			float most = *std::max_element(weights[who].begin(), weights[who].end());
+			for (unsigned code = 0; code < codes; code++)
+				chances[who][code] = most > 0 ? uint8_t(weights[who][code] / most * 255 + 0.5f) : 0;
+		}
+	}
+
+	/**
+	 * the direction that d is moved to by symmetry s, i.e., rotate(s % 4) then reflect if s >= 4
+	 */
+	static int symmetry(int d, int s) {
+		static const int dx[8] = { -1, -1, -1, 0, 0, 1, 1, 1 }, dy[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+		int x = dx[d], y = dy[d];
+		for (int r = 0; r < s % 4; r++) std::swap(x, y), y = -y; // clockwise
+		if (s >= 4) x = -x;
+		for (int k = 0; k < 8; k++)
+			if (dx[k] == x && dy[k] == y) return k;
+		return d;
+	}
+
+	/**
+	 * set the weight of all the codes matching the cells from direction d, where code has the directions before d
+	 * the cells are 0 to 4 for empty, own, opponent, edge, and any
+	 */
+	void assign(const std::array<int, 8>& cells, int d, unsigned code, float weight) {
+		if (d == 8) {
+			weights[board::black][code] = weight;
+			weights[board::white][swapped(code)] = weight;
+			return;
+		}
+		static const unsigned type[4] = { board::empty, board::black, board::white, board::hollow };
+		for (int t = 0; t < 4; t++)
+			if (cells[d] == t || cells[d] == 4)
+				assign(cells, d + 1, code | (type[t] << (2 * d)), weight);
+	}
+
+	/**
+	 * the same pattern with black and white swapped
+	 */
+	static unsigned swapped(unsigned code) {
+		for (int d = 0; d < 8; d++) {
+			unsigned t = (code >> (2 * d)) & 3;
+			if (t == board::black || t == board::white) code ^= 3u << (2 * d);
+		}
+		return code;
+	}
+
+	std::array<std::vector<float>, 3> weights; // indexed by piece_type
+	std::array<std::vector<uint8_t>, 3> chances;
+};
@@ -0,0 +1,252 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * playout.h: Define the light engine for random playouts
+ *
+ * Author: Theory of Computer Games (TCG 2021)
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <cstdint>
+#include <array>
+#include "board.h"
+#include "pattern.h"
+
+/**
+ * xorshift64* random number generator, which is much lighter than the engines of <random>
+ */
+class xorshift {
+public:
+	xorshift(uint64_t seed = 0) { this->seed(seed); }
+	void seed(uint64_t s) { state = s ? s : 0x9e3779b97f4a7c15ull; }
+	uint64_t operator ()() {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 0x2545f4914f6cdd1dull;
+	}
+	/**
+	 * a number in [0, n), by the high bits
+	 */
+	unsigned below(unsigned n) { return unsigned(((operator ()() >> 32) * n) >> 32); }
+
+private:
+	uint64_t state;
+};
+
+/**
+ * the light board for random playouts, which keeps only what is needed to find the legal moves
+ * the legal points of both sides are kept up to date on each placement, where only the empty neighbors
+ * of the placed stone and the last liberties of the blocks just put in atari can change their legality
+ * it has no history, hash, or checks, and uses no virtual call or heap allocation
+ */
+class playout {
+public:
+	typedef board::bitboard bitboard;
+
+	/**
+	 * copy the position of the board
+	 */
+	void reset(const board& b) {
+		empty = b.stones(board::empty);
+		for (int i = 0; i < board::size_x * board::size_y; i++) color[i] = b(i), head[i] = i, code[i] = b.pattern(i);
+		color[edge] = board::hollow;
+		head[edge] = edge;
+		libs[edge] = 0;
+		for (unsigned who = board::black; who <= board::white; who++) {
+			stone[who] = b.stones(who);
+			for (bitboard rest = stone[who]; rest; ) {
+				bitboard blk = board::flood(board::lowest(rest), stone[who]);
+				int h = board::first(blk);
+				block[h] = blk;
+				length[h] = board::count(blk);
+				libs[h] = board::adjacent(blk) & empty;
+				for (bitboard m = blk; m; m &= m - 1) head[board::first(m)] = h;
+				rest &= ~blk;
+			}
+		}
+		legal[board::black] = b.legal_moves(board::black);
+		legal[board::white] = b.legal_moves(board::white);
+	}
+
+	/**
+	 * the legal points of who, same as board::legal_moves()
+	 */
+	bitboard legal_moves(unsigned who) const { return legal[who]; }
+	bitboard stones(unsigned who) const { return stone[who]; }
+
+	/**
+	 * put a stone of who at (i), which should be a legal point of who
+	 */
+	void place(int i, unsigned who) {
+		bitboard p = board::bit(i), near = neighbors()[i].around;
+		empty &= ~p;
+		stone[who] |= p;
+		legal[board::black] &= ~p;
+		legal[board::white] &= ~p;
+		color[i] = who;
+		for (int d = 0; d < 8; d++) code[board::around(i, d)] += who << (2 * (7 - d));
+
+		int h = i;
+		head[i] = i;
+		block[i] = p;
+		length[i] = 1;
+		libs[i] = near & empty;
+		for (bitboard own = near & stone[who]; own; ) { // join the blocks, relabel the smaller one
+			int o = head[board::first(own)];
+			own &= ~block[o];
+			if (length[o] > length[h]) std::swap(h, o);
+			for (bitboard m = block[o]; m; m &= m - 1) head[board::first(m)] = h;
+			block[h] |= block[o];
+			length[h] += length[o];
+			libs[h] |= libs[o];
+		}
+		libs[h] &= ~p;
+		if (!(libs[h] & (libs[h] - 1))) update(board::first(libs[h])); // joined into atari, a legal move keeps a liberty
+		for (bitboard opp = near & stone[3u - who]; opp; ) {
+			int o = head[board::first(opp)];
+			opp &= ~block[o];
+			libs[o] &= ~p;
+			if (!(libs[o] & (libs[o] - 1))) update(board::first(libs[o])); // put in atari
+		}
+		for (bitboard free = near & empty; free; free &= free - 1) {
+			int k = board::first(free);
+			if (!(neighbors()[k].around & empty)) update(k); // lost its last empty neighbor, otherwise only an atari matters
+		}
+	}
+
+
+	/**
+	 * play random moves from who until a side has no legal move, and return the winner
+	 */
+	unsigned run(unsigned who, xorshift& random) {
+		for (bitboard moves; (moves = legal[who]); who = 3u - who)
+			place(pick(moves, random), who);
+		return 3u - who;
+	}
+
+	/**
+	 * play random moves as run(), where the moves are picked in proportion to the weights of their patterns
+	 */
+	unsigned run(unsigned who, xorshift& random, const pattern_table& patterns) {
+		for (bitboard moves; (moves = legal[who]); who = 3u - who)
+			place(pick(moves, random, who, patterns), who);
+		return 3u - who;
+	}
+
+	/**
+	 * the side that wins whoever moves, or board::empty if the game is not decided yet
+	 * the eyes of who, i.e., the empty points whose sides are all stones of who or the edge, can never be played by the other side,
+	 * and who can always fill all of them but one in each group of blocks joined by the eyes, so these moves are guaranteed,
+	 * and who wins if they are more than all the points the other side may ever play
+	 * these are only its legal points now, since a point illegal for the other side stays illegal while who only fills the eyes:
+	 * the last liberty of a block of who is never extended by the eyes, which are liberties of their own blocks,
+	 * and a suicide point has no empty neighbor, so the blocks of the other side around it can never gain a liberty
+	 * the groups are only found when the count of the eyes may be enough, which is rare until the end of the game
+	 */
+	unsigned decided() const {
+		for (unsigned who = board::black; who <= board::white; who++) {
+			bitboard eyes = empty & ~board::adjacent(empty | stone[3u - who]);
+			int sure = board::count(eyes), reach = board::count(legal[3u - who]);
+			if (sure <= reach + 1) continue; // there is at least one group
+			for (bitboard rest = eyes; rest; sure--)
+				rest &= ~board::flood(board::lowest(rest), stone[who] | eyes);
+			if (sure > reach) return who;
+		}
+		return board::empty;
+	}
+
+	/**
+	 * pick a point uniformly from the mask, which should not be empty
+	 * a few random points are tried first, since counting the mask is slow without the popcnt instruction
+	 */
+	static int pick(bitboard moves, xorshift& random) {
+		for (int n = 0; n < 4; n++) {
+			int i = random.below(board::size_x * board::size_y);
+			if ((moves >> i) & 1) return i;
+		}
+		return board::nth(moves, random.below(board::count(moves)));
+	}
+
+	/**
+	 * pick a point of who from the mask in proportion to the weight of its pattern, by rejection from uniform picks
+	 * a point is accepted after a few rejections anyway, so that it is fast even when most of the weights are small
+	 */
+	int pick(bitboard moves, xorshift& random, unsigned who, const pattern_table& patterns) const {
+		int i = pick(moves, random);
+		for (int n = 0; n < 8 && random.below(255) >= patterns.chance(who, code[i]); n++)
+			i = pick(moves, random);
+		return i;
+	}
+
+private:
+	/**
+	 * find the legality of the empty point (i) for both sides from its neighbors
+	 */
+	void update(int i) {
+		// the sides (as bits 1 << who) that a neighbor makes safe or forbids, by its color and whether its block has two or more liberties
+		// an empty neighbor is always a liberty, the last liberty of a block of who is forbidden to the other side
+		static const uint8_t safe_by[8] = { 0b110, 0b110, 0, 0b010, 0, 0b100, 0, 0 };
+		static const uint8_t take_by[8] = { 0, 0, 0b100, 0, 0b010, 0, 0, 0 };
+		const neighbor& near = neighbors()[i];
+		unsigned safe = 0, take = 0;
+		for (int d = 0; d < 4; d++) { // the missing neighbors are the edge, which makes nothing safe or forbidden
+			int k = near.point[d];
+			bitboard l = libs[head[k]];
+			unsigned code = color[k] * 2 + ((l & (l - 1)) != 0);
+			safe |= safe_by[code];
+			take |= take_by[code];
+		}
+		unsigned ok = safe & ~take;
+		bitboard p = board::bit(i);
+		legal[board::black] = (legal[board::black] & ~p) | (p & -bitboard((ok >> board::black) & 1));
+		legal[board::white] = (legal[board::white] & ~p) | (p & -bitboard((ok >> board::white) & 1));
+	}
+
+	/**
+	 * the points next to each point, except for the hollow ones
+	 */
+	struct neighbor {
+		uint8_t point[4]; // padded with the edge
+		int size;
+		bitboard around; // the same points as a mask
+	};
+	enum : int { edge = board::size_x * board::size_y }; // a point out of the board, for padding
+	static const std::array<neighbor, board::size_x * board::size_y>& neighbors() {
+		static std::array<neighbor, board::size_x * board::size_y> table;
+		return table;
+	}
+	static __attribute__((constructor)) void init_neighbors() {
+		std::array<neighbor, board::size_x * board::size_y>& table = const_cast<std::array<neighbor, board::size_x * board::size_y>&>(neighbors());
+		auto hollow = [](int x, int y) { // the same hollow center as board, which may not be initialized yet
+			return x >= (board::size_x - board::hollow_x) / 2 && x < (board::size_x + board::hollow_x) / 2
+			    && y >= (board::size_y - board::hollow_y) / 2 && y < (board::size_y + board::hollow_y) / 2;
+		};
+		const int dx[] = { -1, 1, 0, 0 }, dy[] = { 0, 0, -1, 1 };
+		for (int x = 0; x < board::size_x; x++) {
+			for (int y = 0; y < board::size_y; y++) {
+				neighbor& near = table[board::point(x, y).i];
+				near.size = 0;
+				for (int d = 0; d < 4; d++) {
+					int u = x + dx[d], v = y + dy[d];
+					if (u >= 0 && u < board::size_x && v >= 0 && v < board::size_y && !hollow(u, v))
+						near.point[near.size++] = board::point(u, v).i;
+				}
+				for (int d = near.size; d < 4; d++) near.point[d] = edge;
+				near.around = 0;
+				for (int d = 0; d < near.size; d++) near.around |= board::bit(near.point[d]);
+			}
+		}
+	}
+
+	bitboard empty;
+	std::array<bitboard, 3> stone; // indexed by piece_type, except for empty
+	std::array<bitboard, 3> legal;
+	std::array<uint8_t, edge + 1> color; // the piece_type of each point, the edge is hollow
+	std::array<uint16_t, edge + 1> code; // the pattern code of each point as board::pattern(), the edge is spare
+	std::array<uint8_t, edge + 1> head;
+	std::array<bitboard, edge + 1> block; // the stones of the block, at the head
+	std::array<uint8_t, edge + 1> length; // the number of stones of the block, at the head
+	std::array<bitboard, edge + 1> libs; // the liberties of the block, at the head
+};
@@ -0,0 +1,122 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * recorder.h: Utility for saving the episodes to a file as they are closed
+ *
+ * Author: Theory of Computer Games (TCG 2021)
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <unistd.h>
+#include "episode.h"
+
+/**
+ * streaming writer of the episodes, one line each as episode::operator<<, which is the format of statistic,
+ * or in the binary format of episode::write_binary()
+ * the lines are queued by the game threads and written in batches by a background thread, which flushes each batch,
+ * and also calls fsync every 'sync' milliseconds if it is set, so that a crash loses at most the last batch
+ */
+class recorder {
+public:
+	recorder() : file(nullptr), sync(0), binary(false), done(false) {}
+	~recorder() { close(); }
+
+	/**
+	 * truncate the file and start the writer, return false if the file can not be opened
+	 */
+	bool open(const std::string& path, int sync_ms = 0, bool binary_format = false) {
+		close();
+		file = std::fopen(path.c_str(), "wb");
+		if (!file) return false;
+		std::setvbuf(file, nullptr, _IOFBF, 1 << 16);
+		sync = sync_ms;
+		binary = binary_format;
+		done = false;
+		queue.clear();
+		if (binary) queue.append(episode::binary_magic, std::strlen(episode::binary_magic));
+		writer = std::thread(&recorder::run, this);
+		return true;
+	}
+
+	bool is_open() const { return file; }
+
+	/**
+	 * queue a closed episode to be written, which only formats it and takes a short lock
+	 */
+	void record(const episode& ep) {
+		if (!file) return;
+		std::string line;
+		if (binary) {
+			ep.write_binary(line);
+		} else {
+			std::ostringstream text;
+			text << ep << '\n';
+			line = text.str();
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		queue += line;
+		ready.notify_one();
+	}
+
+	/**
+	 * write all the queued episodes, stop the writer, and close the file
+	 */
+	void close() {
+		if (!file) return;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			done = true;
+			ready.notify_one();
+		}
+		writer.join();
+		std::fclose(file);
+		file = nullptr;
+	}
+
+private:
+	void run() {
+		typedef std::chrono::steady_clock clock;
+		clock::time_point synced = clock::now();
+		bool dirty = false; // written but not synced
+		std::string batch;
+		for (bool last = false; !last; ) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				auto wake = [this]() { return done || queue.size(); };
+				if (sync && dirty) ready.wait_until(lock, synced + std::chrono::milliseconds(sync), wake);
+				else ready.wait(lock, wake);
+				batch.swap(queue);
+				last = done;
+			}
+			if (batch.size()) {
+				std::fwrite(batch.data(), 1, batch.size(), file);
+				std::fflush(file);
+				batch.clear();
+				dirty = true;
+			}
+			if (sync && dirty && (last || clock::now() >= synced + std::chrono::milliseconds(sync))) {
+				fsync(fileno(file));
+				synced = clock::now();
+				dirty = false;
+			}
+		}
+	}
+
+	std::FILE* file;
+	int sync; // the period of fsync in milliseconds, 0 for none
+	bool binary; // the records are written by episode::write_binary()
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::string queue; // the lines not written yet
+	bool done;
+};
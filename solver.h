@@ -0,0 +1,117 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * solver.h: Define the exact solver for the endgame
+ *
+ * Author: Theory of Computer Games (TCG 2021)
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "board.h"
+
+/**
+ * exact solver of win or loss for the side to move, by a depth-first negamax search
+ * since the value is only win or loss, alpha-beta reduces to cutting at the first winning move,
+ * so the move ordering is what matters, where the moves leaving the opponent with fewer legal points are tried first
+ * the results are kept in a transposition table by the hash of the position, which stays valid across searches
+ * the search is given a time limit, and gives up with unknown when it is exceeded
+ */
+class solver {
+public:
+	enum result : int { loss = -1, unknown = 0, win = 1 };
+
+	solver(unsigned bits = 20) : mask((size_t(1) << bits) - 1), nodes(0) {}
+
+	/**
+	 * solve the position for who to move within the time limit (in milliseconds)
+	 * return win or loss for who, or unknown if the time is out, where a winning move is stored to best
+	 */
+	result solve(const board& state, unsigned who, int limit, board::point& best) {
+		if (table.empty()) table.resize(mask + 1); // allocated on the first search, so an unused solver costs nothing
+		board b = state;
+		deadline = clock::now() + std::chrono::milliseconds(limit);
+		timeout = false;
+		nodes = 0;
+		result r = search(b, who, 0);
+		if (timeout) return unknown;
+		best = board::point(r == win ? probe(b.hash()).move : -1);
+		return r;
+	}
+
+	/**
+	 * the number of positions visited by the last search
+	 */
+	uint64_t visits() const { return nodes; }
+
+private:
+	typedef std::chrono::steady_clock clock;
+	typedef board::bitboard bitboard;
+
+	struct entry {
+		uint64_t key;
+		int8_t value; // the result for the side to move, 0 for an empty slot
+		uint8_t move; // the winning move, or the move that resisted the longest
+	};
+
+	entry& probe(uint64_t key) { return table[key & mask]; }
+
+	result search(board& b, unsigned who, unsigned ply) {
+		if ((++nodes & 1023) == 0 && clock::now() > deadline) timeout = true;
+		if (timeout) return unknown;
+		bitboard mine = b.legal_moves(who);
+		if (!mine) return loss;
+		entry& e = probe(b.hash());
+		if (e.key == b.hash() && e.value) return result(e.value);
+
+		// order the moves by the number of legal points the opponent has after them, and the last best move first
+		if (moves.size() <= ply) moves.resize(ply + 1);
+		std::vector<std::pair<int, int> >& order = moves[ply];
+		order.clear();
+		int hint = (e.key == b.hash()) ? e.move : -1;
+		for (bitboard rest = mine; rest; rest &= rest - 1) {
+			int i = board::first(rest);
+			b.play(board::point(i), who);
+			bitboard theirs = b.legal_moves(3u - who);
+			b.undo();
+			if (!theirs) { // the opponent has no move left
+				store(b.hash(), win, i);
+				return win;
+			}
+			order.emplace_back(i == hint ? -1 : board::count(theirs), i);
+		}
+		std::sort(order.begin(), order.end());
+
+		for (size_t k = 0; k < moves[ply].size(); k++) {
+			int i = moves[ply][k].second;
+			b.play(board::point(i), who);
+			result r = result(-search(b, 3u - who, ply + 1));
+			b.undo();
+			if (timeout) return unknown;
+			if (r == win) {
+				store(b.hash(), win, i);
+				return win;
+			}
+		}
+		store(b.hash(), loss, moves[ply].front().second);
+		return loss;
+	}
+
+	void store(uint64_t key, result value, int move) {
+		entry& e = probe(key);
+		e.key = key;
+		e.value = value;
+		e.move = move;
+	}
+
+	std::vector<entry> table;
+	size_t mask;
+	std::vector<std::vector<std::pair<int, int> > > moves; // the ordered moves of each ply
+	clock::time_point deadline;
+	bool timeout;
+	uint64_t nodes;
+};
@@ -8,10 +8,11 @@
  */
 
 #pragma once
-#include <list>
+#include <vector>
 #include <algorithm>
 #include <iostream>
-#include <sstream>
+#include <string>
+#include <mutex>
 #include "board.h"
 #include "action.h"
 #include "agent.h"
@@ -28,9 +29,13 @@ public:
 	 */
 	statistic(size_t total, size_t block = 0, size_t limit = 0)
 		: total(total),
-		  block(block ? block : total),
-		  limit(limit ? limit : total),
-		  count(0) {}
+		  block(std::max<size_t>(block ? block : total, 1)),
+		  limit(std::max<size_t>(limit ? limit : total, 1)),
+		  bounded(limit),
+		  count(0),
+		  started(0),
+		  start(0),
+		  size(0) {}
 
 public:
 	/**
@@ -48,42 +53,15 @@ public:
 	 *  'ops = 125762 (132018|135377)': the average speed is 125762
 	 *                                  the average speed of black is 132018
 	 *                                  the average speed of white is 135377
+	 *
+	 * the sums of the current block are kept up to date as the games are closed, so this is O(1)
 	 */
 	void show() const {
-		size_t blk = std::min(data.size(), block);
-		size_t sop = 0, Bop = 0, Wop = 0;
-		time_t sdu = 0, Bdu = 0, Wdu = 0;
-		size_t BW = 0, WW = 0;
-		auto it = data.end();
-		for (size_t i = 0; i < blk; i++) {
-			auto& ep = *(--it);
-			if (ep.ep_moves.size() % 2 == 1) BW++;
-			else                             WW++;
-			sop += ep.step();
-			Bop += ep.step(action::black::type);
-			Wop += ep.step(action::white::type);
-			sdu += ep.time();
-			Bdu += ep.time(action::black::type);
-			Wdu += ep.time(action::white::type);
-		}
-
-		std::cout << count << "\t";
-		std::cout << "win = " << (BW * 100.0 / blk) << "%"
-		          <<      "|" << (WW * 100.0 / blk) << "%, ";
-		std::cout << "op = "  << (sop * 1.0 / blk)
-		          <<     " (" << (Bop * 1.0 / blk)
-		          <<      "|" << (Wop * 1.0 / blk) << "), ";
-		std::cout << "ops = " << (sop * 1000.0 / sdu)
-		          <<     " (" << (Bop * 1000.0 / Bdu)
-		          <<      "|" << (Wop * 1000.0 / Wdu) << ")";
-		std::cout << std::endl;
+		show(window);
 	}
 
 	void summary() const {
-		auto block_temp = block;
-		const_cast<statistic&>(*this).block = data.size();
-		show();
-		const_cast<statistic&>(*this).block = block_temp;
+		show(retained);
 	}
 
 	bool is_finished() const {
@@ -91,50 +69,138 @@ public:
 	}
 
 	bool is_episode_ongoing() const {
-		return data.size() && data.back().ep_close.when == 0;
+		return current.ep_open.when != 0 && current.ep_close.when == 0;
 	}
 
 	void open_episode(const std::string& flag = "") {
-		if (count++ >= limit) data.pop_front();
-		data.emplace_back();
-		data.back().open_episode(flag);
+		current.clear();
+		current.open_episode(flag);
 	}
 
 	void close_episode(const std::string& flag = "") {
-		data.back().close_episode(flag);
+		current.close_episode(flag);
+		push(current);
 		if (count % block == 0) show();
 	}
 
-	episode& at(size_t i) {
-		auto it = data.begin();
-		while (i--) it++;
-		return *it;
+	/**
+	 * reserve an episode to be run by one of several threads, which is later added by add_episode()
+	 * return the number of the episode from 1, or 0 if all the episodes are already reserved
+	 */
+	size_t reserve() {
+		std::lock_guard<std::mutex> lock(mutex);
+		started = std::max(started, count);
+		if (started >= total) return 0;
+		return ++started;
 	}
-	episode& front() {
-		return data.front();
+
+	/**
+	 * add a closed episode run by one of several threads, so the episodes are kept in the order they are finished
+	 */
+	void add_episode(const episode& ep) {
+		std::lock_guard<std::mutex> lock(mutex);
+		push(ep);
+		if (count % block == 0) show();
+	}
+
+	/**
+	 * add a closed episode loaded from a file
+	 * the records are only bounded by the limit if it is given, otherwise all the loaded episodes are kept
+	 */
+	void load_episode(const episode& ep) {
+		if (!bounded) limit = std::max(limit, count + 1);
+		push(ep);
+		total = std::max(total, count);
 	}
+
+	/**
+	 * the episode played by open_episode() and close_episode()
+	 */
 	episode& back() {
-		return data.back();
+		return current;
+	}
+	const episode& back() const {
+		return current;
 	}
 
-	friend std::ostream& operator <<(std::ostream& out, const statistic& stat) {
-		for (const episode& rec : stat.data) out << rec << std::endl;
-		return out;
+private:
+	/**
+	 * the sums of some episodes for show()
+	 */
+	struct sums {
+		size_t games = 0, black_wins = 0;
+		size_t ops = 0, black_ops = 0, white_ops = 0;
+		time_t time = 0, black_time = 0, white_time = 0;
+
+		sums() = default;
+		sums(const episode& ep) : games(1), black_wins(ep.ep_moves.size() % 2),
+			ops(ep.step()), black_ops(ep.step(action::black::type)), white_ops(ep.step(action::white::type)),
+			time(ep.time()), black_time(ep.time(action::black::type)), white_time(ep.time(action::white::type)) {}
+
+		sums& operator +=(const sums& s) {
+			games += s.games; black_wins += s.black_wins;
+			ops += s.ops; black_ops += s.black_ops; white_ops += s.white_ops;
+			time += s.time; black_time += s.black_time; white_time += s.white_time;
+			return *this;
+		}
+		sums& operator -=(const sums& s) {
+			games -= s.games; black_wins -= s.black_wins;
+			ops -= s.ops; black_ops -= s.black_ops; white_ops -= s.white_ops;
+			time -= s.time; black_time -= s.black_time; white_time -= s.white_time;
+			return *this;
+		}
+	};
+
+	void show(const sums& s) const {
+		size_t blk = s.games;
+		std::cout << count << "\t";
+		std::cout << "win = " << (s.black_wins * 100.0 / blk) << "%"
+		          <<      "|" << ((blk - s.black_wins) * 100.0 / blk) << "%, ";
+		std::cout << "op = "  << (s.ops * 1.0 / blk)
+		          <<     " (" << (s.black_ops * 1.0 / blk)
+		          <<      "|" << (s.white_ops * 1.0 / blk) << "), ";
+		std::cout << "ops = " << (s.ops * 1000.0 / s.time)
+		          <<     " (" << (s.black_ops * 1000.0 / s.black_time)
+		          <<      "|" << (s.white_ops * 1000.0 / s.white_time) << ")";
+		std::cout << std::endl;
 	}
-	friend std::istream& operator >>(std::istream& in, statistic& stat) {
-		for (std::string line; std::getline(in, line) && line.size(); ) {
-			stat.data.emplace_back();
-			std::stringstream(line) >> stat.data.back();
+
+	/**
+	 * keep the closed episode as the newest record and count it into the sums, where the oldest record is dropped
+	 * once there are 'limit' records, and the first episode of a block starts its sums again
+	 * the records are kept in one pool in the binary format of episode::write_binary(), about 100 bytes each,
+	 * and the space of the dropped records is reclaimed once it is half of the pool
+	 */
+	void push(const episode& ep) {
+		if (size == limit) {
+			const char* p = pool.data() + start;
+			dropped.read_binary(p, pool.data() + pool.size());
+			retained -= sums(dropped);
+			start = p - pool.data();
+			size--;
+			if (start > pool.size() / 2) pool.erase(0, start), start = 0;
 		}
-		stat.total = std::max(stat.total, stat.data.size());
-		stat.count = stat.data.size();
-		return in;
+		ep.write_binary(pool);
+		size++;
+		count++;
+		sums last(ep);
+		retained += last;
+		if ((count - 1) % block == 0) window = sums();
+		window += last;
 	}
 
-private:
 	size_t total;
 	size_t block;
 	size_t limit;
+	bool bounded; // the limit is given
 	size_t count;
-	std::list<episode> data;
+	size_t started; // the episodes reserved by reserve()
+	episode current; // the episode being played
+	std::string pool; // the last 'limit' records from 'start', oldest first
+	size_t start; // the bytes of the dropped records at the front of the pool
+	size_t size; // the number of records
+	episode dropped; // the oldest record, read back when it is dropped
+	sums window; // the sums of the episodes of the current block
+	sums retained; // the sums of the records
+	std::mutex mutex; // for reserve() and add_episode()
 };
@@ -0,0 +1,335 @@
+/**
+ * Framework for NoGo and similar games (C++ 11)
+ * tree.h: Define the nodes of the search tree and the arena for storing them
+ *
+ * Author: Theory of Computer Games (TCG 2021)
+ *         Computer Games and Intelligence (CGI) Lab, NYCU, Taiwan
+ *         https://cgilab.nctu.edu.tw/
+ */
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "action.h"
+
+/**
+ * the structure part of a node, the statistics are kept by the arena
+ */
+struct Node
+{
+	uint32_t child; // index of the first child in the arena
+	uint8_t size;   // number of children, which are stored contiguously
+	uint8_t move;   // the point of the move leading to this node, or 0xff for none
+	uint8_t color;  // the color of the move
+	uint8_t flag;
+
+	static constexpr uint8_t expanded = 1; // the children are being (or have been) created
+	static constexpr uint8_t won = 2; // proven, the player of the move wins
+	static constexpr uint8_t lost = 4; // proven, the player of the move loses
+	static constexpr int symmetry_shift = 4; // the high bits of the flag are the symmetry of the children
+
+	action::place selectPlace() const { return action::place(move != 0xff ? move : -1, color); }
+
+	/**
+	 * the symmetry that moves the points of the children to the frame of this node, see board::transformed()
+	 * the children may be shared with a symmetric position, otherwise this is 0
+	 */
+	int symmetry() const { return flag >> symmetry_shift; }
+};
+
+/**
+ * arena for the nodes of one search tree
+ * nodes are referred to by 32-bit indices, which stay valid as the arena grows
+ * the storage is only grown and never freed, so that releasing a tree is O(1) and a long match keeps flat memory
+ *
+ * the storage is a table of fixed-size segments that are never moved, so that the arena can be grown
+ * by several search threads at once, and the children of a node are always in one segment
+ * the statistics are stored as structure of arrays, so that the statistics of the children of a node
+ * are contiguous in each array and can be scored with SIMD
+ */
+class node_arena
+{
+public:
+	typedef uint32_t index;
+	static constexpr index none = -1u;
+
+	node_arena() : table(new std::atomic<segment *>[max_segments]), top(0)
+	{
+		for (size_t i = 0; i < max_segments; i++)
+			table[i].store(nullptr);
+	}
+	~node_arena()
+	{
+		for (size_t i = 0; i < max_segments; i++)
+			delete table[i].load();
+	}
+
+	Node &operator[](index i) { return at(i).nodes[i & segment_mask]; }
+	const Node &operator[](index i) const { return at(i).nodes[i & segment_mask]; }
+
+	int &nb(index i) { return at(i).nb[i & segment_mask]; }
+	float &value(index i) { return at(i).value[i & segment_mask]; }
+	int &nb_rave(index i) { return at(i).nb_rave[i & segment_mask]; }
+	float &value_rave(index i) { return at(i).value_rave[i & segment_mask]; }
+	float &h(index i) { return at(i).h[i & segment_mask]; }
+	int nb(index i) const { return at(i).nb[i & segment_mask]; }
+	float value(index i) const { return at(i).value[i & segment_mask]; }
+
+	/**
+	 * initialize the node with the move and the initial statistics
+	 */
+	void create(index i, action::place move, int nb_rave = 0, float value_rave = 0, float h = 0)
+	{
+		segment &s = at(i);
+		i &= segment_mask;
+		s.nodes[i] = Node{0, 0, uint8_t(move.position().i), uint8_t(move.color()), 0};
+		s.nb[i] = 0;
+		s.value[i] = 0;
+		s.nb_rave[i] = nb_rave;
+		s.value_rave[i] = value_rave;
+		s.h[i] = h;
+	}
+
+	/**
+	 * allocate a contiguous block of n nodes, return the index of the first one, or none if the arena is full
+	 * this is safe to be called by several threads at once
+	 */
+	index allocate(uint32_t n)
+	{
+		index last = top.load(std::memory_order_relaxed), first;
+		do
+		{
+			first = ((last & segment_mask) + n > segment_size) ? (last | segment_mask) + 1 : last;
+		} while (!top.compare_exchange_weak(last, first + n, std::memory_order_relaxed));
+		if (uint64_t(first) + n > uint64_t(max_segments) * segment_size)
+			return none;
+		if (n)
+			prepare(first >> segment_bits);
+		return first;
+	}
+
+	/**
+	 * release all the nodes
+	 */
+	void reset() { top.store(0); }
+
+	/**
+	 * keep only the subtree at the given node and release all the others
+	 * the subtree is packed into the spare storage, and its root becomes node 0, then the segments of the packed
+	 * subtree are swapped in, so that the spare storage is only as large as the largest subtree kept
+	 * the children shared by several nodes are copied once, so the subtree may be a DAG
+	 */
+	index keep(index root)
+	{
+		node_arena &to = *spare();
+		to.reset();
+		to.copy(to.allocate(1), *this, root, 1);
+		copied.clear();
+		pending.assign(1, 0);
+		while (pending.size())
+		{
+			Node &node = to[pending.back()];
+			pending.pop_back();
+			if (node.size == 0)
+				continue;
+			auto shared = copied.find(node.child);
+			if (shared != copied.end())
+			{
+				node.child = shared->second;
+				continue;
+			}
+			index from = node.child;
+			node.child = copied[from] = to.allocate(node.size);
+			to.copy(node.child, *this, from, node.size);
+			for (index k = 0; k < node.size; k++)
+				pending.push_back(node.child + k);
+		}
+		for (index s = 0; s < (to.top.load() + segment_mask) >> segment_bits; s++)
+		{
+			segment *packed = to.table[s].load();
+			to.table[s].store(table[s].load());
+			table[s].store(packed);
+		}
+		top.store(to.top.load());
+		to.reset();
+		return 0;
+	}
+
+	size_t size() const { return top.load(); }
+
+public:
+	/**
+	 * thread-safe updates of the statistics
+	 */
+	static void add(int &x, int v) { __atomic_fetch_add(&x, v, __ATOMIC_RELAXED); }
+	static void add(float &x, float v)
+	{
+		float last, next;
+		__atomic_load(&x, &last, __ATOMIC_RELAXED);
+		do
+		{
+			next = last + v;
+		} while (!__atomic_compare_exchange(&x, &last, &next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	}
+
+	/**
+	 * lighter updates for the statistics where a few lost updates do not matter, e.g., the RAVE ones
+	 * an update may be lost if several threads update the same statistic at once
+	 */
+	static void accumulate(int &x, int v) { __atomic_store_n(&x, __atomic_load_n(&x, __ATOMIC_RELAXED) + v, __ATOMIC_RELAXED); }
+	static void accumulate(float &x, float v)
+	{
+		float y;
+		__atomic_load(&x, &y, __ATOMIC_RELAXED);
+		y += v;
+		__atomic_store(&x, &y, __ATOMIC_RELAXED);
+	}
+
+private:
+	enum : uint32_t { segment_bits = 16, segment_size = 1u << segment_bits, segment_mask = segment_size - 1, max_segments = 1u << 12 };
+
+	struct segment
+	{
+		Node nodes[segment_size];
+		int nb[segment_size];
+		float value[segment_size];
+		int nb_rave[segment_size];
+		float value_rave[segment_size];
+		float h[segment_size];
+	};
+
+	segment &at(index i) const { return *table[i >> segment_bits].load(std::memory_order_acquire); }
+
+	void prepare(index s)
+	{
+		if (table[s].load(std::memory_order_acquire))
+			return;
+		std::lock_guard<std::mutex> lock(grow);
+		if (!table[s].load(std::memory_order_relaxed))
+			table[s].store(new segment, std::memory_order_release);
+	}
+
+	void copy(index to, const node_arena &arena, index from, uint32_t n)
+	{
+		if (n == 0)
+			return;
+		segment &d = at(to), &s = arena.at(from);
+		to &= segment_mask;
+		from &= segment_mask;
+		std::copy(s.nodes + from, s.nodes + from + n, d.nodes + to);
+		std::copy(s.nb + from, s.nb + from + n, d.nb + to);
+		std::copy(s.value + from, s.value + from + n, d.value + to);
+		std::copy(s.nb_rave + from, s.nb_rave + from + n, d.nb_rave + to);
+		std::copy(s.value_rave + from, s.value_rave + from + n, d.value_rave + to);
+		std::copy(s.h + from, s.h + from + n, d.h + to);
+	}
+
+	node_arena *spare()
+	{
+		if (!buffer)
+			buffer.reset(new node_arena);
+		return buffer.get();
+	}
+
+	std::unique_ptr<std::atomic<segment *>[]> table;
+	std::atomic<index> top;
+	std::mutex grow;
+	std::unique_ptr<node_arena> buffer; // the spare storage for keep()
+	std::vector<index> pending; // the nodes to be copied by keep()
+	std::unordered_map<index, index> copied; // the children already copied by keep()
+};
+
+/**
+ * lock-free transposition table from the hashes of positions to the children in an arena,
+ * so that a position reached by different move orders shares its children and their statistics
+ * the table has a fixed size, each bucket has two slots, where the second one is always replaced
+ * a slot keeps the hash xor the data, so that a slot torn by threads storing at once is never matched
+ * the entries are valid in the generation when they are stored, which is advanced when the arena is reset or packed
+ */
+class transposition_table
+{
+public:
+	struct entry
+	{
+		node_arena::index child;
+		uint8_t size;
+		uint8_t symmetry; // the symmetry that moves the points of the children to the canonical frame
+	};
+
+	transposition_table() : bits(0), generation(1) {}
+
+	/**
+	 * allocate 2^bits slots, or disable the table with 0 bits
+	 */
+	void resize(unsigned n)
+	{
+		if (n == bits)
+			return;
+		bits = n;
+		table.reset(n ? new slot[size_t(1) << n]() : nullptr);
+		generation = 1;
+	}
+	bool enabled() const { return bits; }
+
+	/**
+	 * invalidate all the entries, where a disabled table has no slots to clear when the generation wraps
+	 */
+	void renew()
+	{
+		if (!enabled())
+		{
+			generation = 1;
+			return;
+		}
+		if (++generation < (1u << generation_bits))
+			return;
+		for (size_t i = 0; i < (size_t(1) << bits); i++)
+			table[i].data.store(0), table[i].check.store(0);
+		generation = 1;
+	}
+
+	bool find(uint64_t key, entry &e) const
+	{
+		for (size_t i = bucket(key); i < bucket(key) + 2; i++)
+		{
+			uint64_t data = table[i].data.load(std::memory_order_acquire);
+			if ((table[i].check.load(std::memory_order_acquire) ^ data) == key && (data >> 43) == generation)
+			{
+				e = entry{uint32_t(data), uint8_t(data >> 32), uint8_t((data >> 40) & 7)};
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void store(uint64_t key, const entry &e)
+	{
+		size_t i = bucket(key);
+		uint64_t data = table[i].data.load(std::memory_order_relaxed);
+		if ((data >> 43) == generation && (table[i].check.load(std::memory_order_relaxed) ^ data) != key)
+			i++;
+		data = uint64_t(e.child) | (uint64_t(e.size) << 32) | (uint64_t(e.symmetry & 7) << 40) | (uint64_t(generation) << 43);
+		table[i].data.store(data, std::memory_order_release);
+		table[i].check.store(key ^ data, std::memory_order_release);
+	}
+
+private:
+	enum : uint32_t { generation_bits = 21 };
+
+	struct slot
+	{
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data; // child (32), size (8), symmetry (3), generation (21)
+	};
+
+	size_t bucket(uint64_t key) const { return key & ((size_t(1) << bits) - 2); }
+
+	std::unique_ptr<slot[]> table;
+	unsigned bits;
+	uint32_t generation;
+};